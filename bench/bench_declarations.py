@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Times `int v0, v1, ..., vN;` declarations for growing N.
+
+Usage: python3 bench/bench_declarations.py [path/to/compiler]
+
+Each size is compiled a few times in a scratch directory (the compiler writes
+its outputs to the working directory) and the fastest run is kept. Results go
+to bench/bench_output.txt; time per name should stay roughly flat if declaration
+handling is linear.
+"""
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SIZES = [1000, 2000, 4000, 6000, 8000, 10000]
+RUNS = 3
+
+
+def time_compile(compiler, source, workdir):
+    path = os.path.join(workdir, "input.txt")
+    with open(path, "w") as f:
+        f.write(source)
+    best = None
+    for _ in range(RUNS):
+        start = time.perf_counter()
+        result = subprocess.run([compiler, "--max-errors", "0", path], cwd=workdir,
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.exit(f"compiler exited with {result.returncode} for {len(source)} bytes")
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    compiler = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, "compiler"))
+
+    lines = [f"{'names':>8} {'seconds':>10} {'us/name':>10}"]
+    with tempfile.TemporaryDirectory() as workdir:
+        baseline = time_compile(compiler, "int v;\n", workdir)
+        for n in SIZES:
+            source = "int " + ", ".join(f"v{i}" for i in range(n)) + ";\n"
+            elapsed = max(time_compile(compiler, source, workdir) - baseline, 0.0)
+            lines.append(f"{n:>8} {elapsed:>10.4f} {elapsed / n * 1e6:>10.2f}")
+
+    report = "\n".join(lines) + "\n"
+    with open(os.path.join(root, "bench", "bench_output.txt"), "w") as f:
+        f.write(report)
+    print(report, end="")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,4 +1,5 @@
 import sys
+import json
 import subprocess
 import shutil
 import os
@@ -179,21 +180,31 @@ class CompilerGUI(QWidget):
         semantic_lines = []
         warning_lines = []
 
-        if result.stdout:
-            for line in result.stdout.splitlines():
-                if "Syntax Error" in line:
-                    syntax_lines.append(line)
-                elif "Semantic Warning" in line:
-                    warning_lines.append(line)
-
-        if result.stderr:
-            semantic_lines.extend(result.stderr.splitlines())
+        labels = {"syntax": "Syntax Error", "semantic": "Semantic Error",
+                  "warning": "Semantic Warning", "fatal": "Fatal Error"}
+        for diag in self.load_diagnostics():
+            line = f"{labels.get(diag['kind'], 'Error')} (line {diag['line']}): {diag['message']}"
+            if diag["kind"] == "syntax":
+                syntax_lines.append(line)
+            elif diag["kind"] == "warning":
+                warning_lines.append(line)
+            else:
+                semantic_lines.append(line)
 
         self.highlight_errors(self.syntaxErrorText, syntax_lines)
         self.highlight_errors(self.semanticErrorText, semantic_lines)
         self.highlight_errors(self.warningTab, warning_lines, warning=True)
         self.load_output_files()
 
+    def load_diagnostics(self):
+        diagnostics = []
+        if os.path.exists("diagnostics.jsonl"):
+            with open("diagnostics.jsonl", "r") as f:
+                for line in f:
+                    if line.strip():
+                        diagnostics.append(json.loads(line))
+        return diagnostics
+
     def highlight_errors(self, text_widget, lines, warning=False):
         text_widget.clear()
         for line in lines:
@@ -230,7 +241,8 @@ class CompilerGUI(QWidget):
         file_map = {
             "symbol_table.txt": "symbol_table.txt",
             "quadruples.txt": "quadruples.txt",
-            "output.asm": "output.asm"
+            "output.asm": "output.asm",
+            "diagnostics.jsonl": "diagnostics.jsonl"
         }
         for src, dst in file_map.items():
             if os.path.exists(src):
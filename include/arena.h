@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator made of chained chunks. Everything allocated from an arena
+// is released at once by arena_reset or arena_release.
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size;
+    size_t used;
+    // data follows
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk *head;   // chunk currently being filled
+    size_t chunk_size;
+} Arena;
+
+// Position in an arena, everything allocated after it can be released
+typedef struct {
+    ArenaChunk *chunk;
+    size_t used;
+} ArenaMark;
+
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+void arena_init(Arena *arena, size_t chunk_size);
+void *arena_alloc(Arena *arena, size_t size);
+char *arena_strdup(Arena *arena, const char *s);
+
+ArenaMark arena_mark(Arena *arena);
+void arena_release(Arena *arena, ArenaMark mark);
+
+// Drops every allocation but keeps one chunk for reuse
+void arena_reset(Arena *arena);
+void arena_free(Arena *arena);
+
+#endif
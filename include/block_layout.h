@@ -0,0 +1,25 @@
+#ifndef BLOCK_LAYOUT_H
+#define BLOCK_LAYOUT_H
+
+// Expected number of taken jumps, weighted by how often each block runs
+typedef struct {
+    double takenBefore;
+    double takenAfter;
+} LayoutStats;
+
+// Reads "label count" lines giving how often each label was reached.
+// Labels that are missing fall back to the static estimates. Returns -1
+// if the file cannot be read.
+int load_block_profile(const char *filename);
+
+// Code at this label is expected to run rarely (switch defaults)
+void mark_cold_label(const char *label);
+
+// Reorders the basic blocks of every function and of the top-level code
+// so that the likely successor of a block follows it, inverting branches
+// and dropping jumps to the next block. Adds the estimated taken jumps
+// before and after to stats, and if report is set prints them for every
+// function that changed.
+void layout_blocks(LayoutStats *stats, int report);
+
+#endif
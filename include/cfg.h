@@ -0,0 +1,49 @@
+#ifndef CFG_H
+#define CFG_H
+
+// Control flow graph over one region of the quadruple list. A region is a
+// function body or the top-level code, which skips over function bodies.
+
+typedef struct {
+    int first;          // positions in Cfg.quads, [first, last)
+    int last;
+    int succ[2];
+    int succCount;
+    int *preds;
+    int predCount;
+    int idom;           // immediate dominator, -1 for the entry and unreachable blocks
+    int rpo;            // position in reverse postorder, -1 if unreachable
+    int *frontier;      // dominance frontier
+    int frontierCount;
+} BasicBlock;
+
+typedef struct {
+    int *quads;         // quad indices in program order
+    int quadCount;
+    BasicBlock *blocks; // blocks[0] is the entry
+    int blockCount;
+    int *order;         // reachable blocks in reverse postorder
+    int orderCount;
+} Cfg;
+
+typedef struct {
+    const char *name;   // function name, "main" for the top-level code
+    int *quads;
+    int count;
+} Region;
+
+// Top-level code plus one region per function. Functions that contain
+// another function are left out, the inner function gets its own region.
+Region *collect_regions(int *count);
+void free_regions(Region *regions, int count);
+
+Cfg *build_cfg(const int *quads, int count);
+void compute_dominators(Cfg *cfg);
+void compute_dominance_frontiers(Cfg *cfg);
+void free_cfg(Cfg *cfg);
+
+// Label a jump quad transfers to, NULL for other quads
+const char *jump_target(int quad);
+int is_conditional_jump(int quad);
+
+#endif
@@ -1,14 +1,26 @@
 #ifndef ERROR_HANDLER_H
 #define ERROR_HANDLER_H
 
-// Type of error (semantic or syntax)
+// Type of diagnostic (semantic or syntax error, or a warning)
 typedef enum {
     SYNTAX_ERROR,
-    SEMANTIC_ERROR
+    SEMANTIC_ERROR,
+    SEMANTIC_WARNING
 } ErrorType;
 
+// Errors reported before the compile is aborted (0 disables the cutoff)
+#define DEFAULT_MAX_ERRORS 100
+
+// Diagnostics are streamed to this file as JSON Lines while compiling
+void open_diagnostics(const char *filename);
+void close_diagnostics();
+void set_max_errors(int max_errors);
+
 // Function declarations
 void report_error(ErrorType type, const char *message, int line);
+void report_diagnostic(ErrorType type, const char *code, int line, const char *symbol, const char *format, ...);
+// Prints the first diagnostics that were reported and how many more
+// there are; all of them are in the diagnostics file
 void print_all_errors();
 int get_error_count();
 
@@ -0,0 +1,10 @@
+#ifndef GVN_H
+#define GVN_H
+
+// Removes quads that recompute a value already held by a temporary
+// (arithmetic, comparisons, conversions), across basic blocks. If report is
+// set, prints the number of quads removed from each function. Returns the
+// total.
+int global_value_numbering(int report);
+
+#endif
@@ -1,14 +1,20 @@
 #ifndef HELPERS_H
 #define HELPERS_H
 
-char** split(const char* str, const char* delimiter, int* count);
+// Names of a declaration like "int a, b, c", in source order. The names
+// are interned (see internName) and not owned by the list.
+typedef struct {
+    const char **names;
+    int count;
+    int capacity;
+} NameList;
 
-void free_split_result(char** result, int count);
+NameList *createNameList(const char *name);
+NameList *appendName(NameList *list, const char *name);
+void freeNameList(NameList *list);
 
 bool areTypesCompatible(ValueType t1, ValueType t2);
 
-char* concat_with_comma(const char* str1, const char* str2);
-
 const char* typeToString(ValueType type);
 
-#endif // SPLIT_H
+#endif // HELPERS_H
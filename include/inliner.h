@@ -0,0 +1,11 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+// Largest function body (in quads, excluding the entry LABEL) that gets inlined
+#define INLINE_MAX_BODY_QUADS 16
+
+// Replaces calls to small, non-recursive functions with a renamed copy of
+// their body. Returns the number of call sites that were inlined.
+int inline_functions();
+
+#endif
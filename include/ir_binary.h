@@ -0,0 +1,66 @@
+#ifndef IR_BINARY_H
+#define IR_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary quadruple file (.qir), laid out as:
+//   QirHeader
+//   uint32_t string_offsets[string_count]   offsets into the string data
+//   char     string_data[string_bytes]      NUL-terminated, padded to 4 bytes
+//   QirQuad  quads[quad_count]
+//   QirLabel labels[label_count]
+// Fields are in host byte order. Every string is stored once and quads refer
+// to it by index, QIR_NONE marks an empty operand.
+
+#define QIR_MAGIC "QIR1"
+#define QIR_VERSION 2
+#define QIR_NONE 0xFFFFFFFFu
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t quad_count;
+    uint32_t string_count;
+    uint32_t string_bytes;
+    uint32_t label_count;
+} QirHeader;
+
+typedef struct {
+    uint32_t op;
+    uint32_t arg1;
+    uint32_t arg2;
+    uint32_t result;
+} QirQuad;
+
+// Position of every LABEL quad, sorted by name so that jump targets are
+// found by binary search
+typedef struct {
+    uint32_t name;
+    uint32_t quad;
+} QirLabel;
+
+// Read-only view of a mapped .qir file, pointers refer into the mapping
+typedef struct {
+    void *base;
+    size_t size;
+    const QirHeader *header;
+    const uint32_t *string_offsets;
+    const char *strings;
+    const QirQuad *quads;
+    const QirLabel *labels;
+} QirFile;
+
+int write_quadruples_binary(const char *filename);
+
+// Maps a .qir file and validates its layout. Returns 0 on success.
+int qir_open(const char *filename, QirFile *file);
+void qir_close(QirFile *file);
+const char *qir_string(const QirFile *file, uint32_t index);
+int qir_find_label(const QirFile *file, const char *name);
+
+// Replaces the current quadruples with the contents of a .qir file.
+// Returns the number of quads loaded, or -1 on error.
+int load_quadruples_binary(const char *filename);
+
+#endif
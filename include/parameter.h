@@ -2,19 +2,27 @@
 #define PARAMETER_H
 
 #include <stdbool.h>
+#include "value_type.h"
 
 typedef struct Parameter {
     char *name;
-    char *type;
+    ValueType type;
     struct Parameter *next;
 } Parameter;
 
-Parameter* createParameter(const char *name, const char *type);
+Parameter* createParameter(const char *name, ValueType type);
 Parameter* addParameter(Parameter *head, Parameter *param);
 void freeParameterList(Parameter *head);
 void printParameterList(const Parameter *head);
 char* parameterListToString(const Parameter* head);
-bool compareParameters(Parameter* declared, Parameter* passed);
+
+// Interned parameter type lists: equal lists get equal IDs, so checking
+// a call against a declaration is a single integer compare
+#define EMPTY_SIGNATURE 0
+
+int extendSignature(int signature, ValueType type);
+int signatureOf(const Parameter *head);
+void clearSignatures();
 
 
 #endif // PARAMETER_H
@@ -1,6 +1,9 @@
 #ifndef QUAD_TO_ASM_H
 #define QUAD_TO_ASM_H
 
+#include <stdio.h>
+
 void convert_quadruples_to_assembly(const char *filename);
+void write_assembly(FILE *fp, int first);
 
 #endif 
\ No newline at end of file
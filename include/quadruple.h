@@ -1,6 +1,8 @@
 #ifndef QUADRUPLE_H
 #define QUADRUPLE_H
 
+#include <stdio.h>
+
 #define MAX_QUADS 1000
 
 // This header is used by both the IR and the assembly generator
@@ -35,7 +37,15 @@ typedef enum {
     OP_ITOF,
     OP_FTOI,
     OP_CTOI,
-    OP_ITOB
+    OP_ITOB,
+    OP_IF_LT,   // compare arg1 with arg2 and jump to result
+    OP_IF_GT,
+    OP_IF_LTE,
+    OP_IF_GTE,
+    OP_IF_EQ,
+    OP_IF_NEQ,
+    OP_TAILCALL,  // call whose value is returned directly, reuses the caller's return
+    OP_COUNT  // number of opcodes, new ones go above this line
 } OpType;
 
 typedef struct {
@@ -45,8 +55,17 @@ typedef struct {
     char *result;
 } Quadruple;
 
+// Jumps whose target label is filled in later by backpatch()
+typedef struct PatchList {
+    int quad;
+    struct PatchList *next;
+} PatchList;
+
 extern Quadruple quadruples[MAX_QUADS];
 extern int quad_count;
+// Quads before this index were already written out in streaming mode and
+// are only kept as function bodies for the inliner (0 otherwise)
+extern int quad_stream_start;
 
 void add_quadruple(OpType op, const char *arg1, const char *arg2, const char *result);
 char *new_temp();
@@ -54,5 +73,17 @@ char *new_label();
 void print_quadruples();
 void free_quadruples();
 const char* get_op_string(OpType op);
+int get_op_from_string(const char *name);
+void write_quadruples_text(FILE *fp);
+void write_quadruple_range(FILE *fp, int first, int number);
+int read_quadruples_text(FILE *fp);
+int is_temp(const char *name);
+PatchList *makelist(int quad);
+PatchList *merge(PatchList *a, PatchList *b);
+void backpatch(PatchList *list, const char *label);
+int is_label(const char *name);
+int is_compare_branch(OpType op);
+int compare_branch_op(OpType relop);
+int invert_branch(OpType op);
 
 #endif
\ No newline at end of file
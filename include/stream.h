@@ -0,0 +1,16 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+// Quads of small functions kept after they were written, so that later
+// code can still inline calls to them
+#define STREAM_KEPT_QUADS (MAX_QUADS / 4)
+
+// Streaming mode: every completed top-level statement or function is
+// optimized and appended to the output files right away, then its quads
+// and local scopes are released
+void stream_begin(const char *quad_file, const char *asm_file, const char *symbol_file);
+int stream_active();
+void stream_flush();
+void stream_end();
+
+#endif
@@ -5,17 +5,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include "value_type.h"
 #include "parameter.h"
 
-typedef enum {
-    INT_TYPE,
-    FLOAT_TYPE,
-    STRING_TYPE,
-    BOOL_TYPE,
-    CHAR_TYPE,
-    VOID_TYPE
-} ValueType;
-
 typedef union {
     char *sVal;
     int iVal;
@@ -28,6 +20,10 @@ typedef struct expression {
     int type;
     Value value;
     char *temp_var;
+    // Conditions compiled to jumps: unpatched jumps taken when the
+    // condition is true or false. Both NULL for plain values.
+    struct PatchList *truelist;
+    struct PatchList *falselist;
 } expr;
 
 typedef struct SymbolTable {
@@ -39,11 +35,22 @@ typedef struct SymbolTable {
     bool isFunction;
     Value value;
     Parameter *params;
+    int signature;   // functions: interned parameter types, see signatureOf
+    int line;        // line of the declaration
+    int quadStart;   // functions: index of the entry LABEL quad, -1 otherwise
+    int quadEnd;     // functions: one past the trailing RETURN quad
+    unsigned int nameHash;
     struct SymbolTable *next;
+    struct SymbolTable *hashNext;  // next entry in the same index bucket
 } SymbolTableEntry;
 
 typedef struct Scope {
     SymbolTableEntry *symbols;
+    SymbolTableEntry *tail;   // last entry, new symbols are appended here
+    SymbolTableEntry **index; // hash buckets over interned names
+    int indexSize;
+    int symbolCount;
+    int position;             // index in allScopes
     struct Scope *parent;
 } Scope;
 
@@ -58,16 +65,20 @@ void exitScope();
 void removeScope();
 void addScope();
 
-void *addSymbol(char *name, char *type, bool isIntialized , Value value , bool isConst , bool isFunction, Parameter *params); // add intialize here
+void *addSymbol(const char *name, ValueType type, bool isIntialized , Value value , bool isConst , bool isFunction, Parameter *params); // add intialize here
 SymbolTableEntry *lookupSymbol(char *name);
+const char *internName(const char *name);
+SymbolTableEntry *lookupFunction(const char *name);
+void remapFunctionQuadRanges(const int *newIndex);
+SymbolTableEntry **collectFunctions(int *count);
 int updateSymbolValue(char *name, Value newValue);
-bool isSymbolDeclaredInCurrentScope(char *name);
+bool isSymbolDeclaredInCurrentScope(const char *name);
 void addParamsToSymbolTable(const Parameter* head);
 
 void writeSymbolTableOfAllScopesToFile(FILE *file);
-void clearSymbolTables(Scope *scope);
+void releaseLocalScopes(FILE *file);
+void clearSymbolTables();
 
-ValueType mapStringToValueType(const char *typeStr);
 const char *valueTypeToString(ValueType type);
 
 void handleDec(char *identifier);
@@ -0,0 +1,11 @@
+#ifndef TAIL_CALLS_H
+#define TAIL_CALLS_H
+
+// Turns `return f(...)` inside a function into a jump. The arguments are
+// assigned to f's parameters, then a call of the enclosing function jumps
+// back to its label and any other call becomes a TAIL_CALL, which leaves
+// through f's RETURN. Runs after inlining so that calls which were inlined
+// are never turned into jumps. Returns the number of calls converted.
+int convert_tail_calls();
+
+#endif
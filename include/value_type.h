@@ -0,0 +1,13 @@
+#ifndef VALUE_TYPE_H
+#define VALUE_TYPE_H
+
+typedef enum {
+    INT_TYPE,
+    FLOAT_TYPE,
+    STRING_TYPE,
+    BOOL_TYPE,
+    CHAR_TYPE,
+    VOID_TYPE
+} ValueType;
+
+#endif // VALUE_TYPE_H
@@ -10,6 +10,12 @@
 #include "error_handler.h"
 #include "quadruple.h"
 #include "quad_to_asm.h"
+#include "inliner.h"
+#include "ir_binary.h"
+#include "gvn.h"
+#include "tail_calls.h"
+#include "stream.h"
+#include "block_layout.h"
 
 extern int yylex();
 extern int yyparse();
@@ -88,23 +94,136 @@ char* convert_char_to_int_if_needed(expr *e) {
     return e->temp_var;
 }
 
-// Convert int to bool (ITOB)
-char* convert_to_bool_if_needed(expr *e) {
-    if (e->type == INT_TYPE) {
-        char *arg = e->temp_var ? e->temp_var : malloc(50);
-        if (!e->temp_var)
-            sprintf(arg, "%d", e->value.iVal);
+// Temp, variable or literal text of a value expression (caller frees)
+char* expr_to_operand(expr *e) {
+    if (e->temp_var)
+        return strdup(e->temp_var);
 
-        char *temp_var_name = new_temp();
-        add_quadruple(OP_ITOB, arg, NULL, temp_var_name);
+    char *operand = malloc(50);
+    switch (e->type) {
+        case INT_TYPE:   sprintf(operand, "%d", e->value.iVal); break;
+        case FLOAT_TYPE: sprintf(operand, "%f", e->value.fVal); break;
+        case BOOL_TYPE:  sprintf(operand, "%s", e->value.bVal ? "true" : "false"); break;
+        case CHAR_TYPE:  sprintf(operand, "'%c'", e->value.cVal); break;
+        default:         strcpy(operand, "unknown");
+    }
+    return operand;
+}
 
-        if (!e->temp_var)
-            free(arg);
+// The last quad, if it computes the temp name with op (any op if op < 0)
+static Quadruple *last_quad_for(const char *name, int op) {
+    if (!name || !is_temp(name) || quad_count == 0) return NULL;
+    Quadruple *last = &quadruples[quad_count - 1];
+    if (!last->result || strcmp(last->result, name) != 0) return NULL;
+    return (op < 0 || (int)last->op == op) ? last : NULL;
+}
 
-        e->type = BOOL_TYPE;
-        e->temp_var = temp_var_name;
+// Turns a value into jumping code: a conditional jump taken when it is
+// true and a jump taken when it is false, both left unpatched. A NOT and
+// a comparison that were just emitted for this value are folded into the
+// jump, so `a < b` becomes a single IF_LT and `not flag` an IF_FALSE.
+void make_jumping(expr *e) {
+    if (e->truelist || e->falselist)
+        return;
+
+    char *operand = expr_to_operand(e);
+    int negate = 0;
+    Quadruple *last = last_quad_for(operand, OP_NOT);
+    if (last) {
+        free(operand);
+        free(last->result);
+        operand = last->arg1;
+        negate = 1;
+        quad_count--;
+    }
+
+    last = last_quad_for(operand, -1);
+    int branch = last ? compare_branch_op(last->op) : -1;
+    if (branch >= 0 && negate) branch = invert_branch(branch);
+    if (branch >= 0) {
+        e->truelist = makelist(quad_count - 1);
+        free(last->result);
+        last->op = branch;
+        last->result = NULL;
+    } else {
+        e->truelist = makelist(quad_count);
+        add_quadruple(negate ? OP_IFFALSE : OP_IFGOTO, operand, NULL, NULL);
     }
-    return e->temp_var;
+    free(operand);
+    e->falselist = makelist(quad_count);
+    add_quadruple(OP_GOTO, NULL, NULL, NULL);
+    e->temp_var = NULL;
+}
+
+// Link pointing at the entry for quad in *list, or NULL
+static PatchList **find_patch(PatchList **list, int quad) {
+    for (; *list; list = &(*list)->next) {
+        if ((*list)->quad == quad) return list;
+    }
+    return NULL;
+}
+
+static void unlink_patch(PatchList **link) {
+    PatchList *found = *link;
+    *link = found->next;
+    free(found);
+}
+
+// Emits label right after the jumping code of e as the target of its true
+// jumps (on_true) or its false jumps. The trailing GOTO of the code is
+// dropped so that this case falls through; if the GOTO belonged to the
+// other case, the branch before it is inverted to take its place.
+void emit_fallthrough_label(expr *e, int on_true, const char *label) {
+    PatchList **here = on_true ? &e->truelist : &e->falselist;
+    PatchList **other = on_true ? &e->falselist : &e->truelist;
+    int last = quad_count - 1;
+
+    if (last >= 0 && quadruples[last].op == OP_GOTO && !quadruples[last].result) {
+        PatchList **jump = find_patch(here, last);
+        PatchList **branch = last > 0 ? find_patch(here, last - 1) : NULL;
+        PatchList **jump_away = find_patch(other, last);
+        if (jump) {
+            unlink_patch(jump);
+            quad_count--;
+        } else if (branch && jump_away && invert_branch(quadruples[last - 1].op) >= 0) {
+            unlink_patch(branch);
+            unlink_patch(jump_away);
+            quadruples[last - 1].op = invert_branch(quadruples[last - 1].op);
+            *other = merge(*other, makelist(last - 1));
+            quad_count--;
+        }
+    }
+
+    backpatch(*here, label);
+    *here = NULL;
+    add_quadruple(OP_LABEL, NULL, NULL, label);
+}
+
+// Stores the outcome of jumping code in a temp so it can be used as a value
+void materialize_bool(expr *e) {
+    if (!e->truelist && !e->falselist)
+        return;
+
+    char *temp = new_temp();
+    char *true_label = new_label();
+    char *false_label = new_label();
+    char *end_label = new_label();
+
+    emit_fallthrough_label(e, 1, true_label);
+    backpatch(e->falselist, false_label);
+    add_quadruple(OP_ASSIGN, "true", NULL, temp);
+    add_quadruple(OP_GOTO, NULL, NULL, end_label);
+    add_quadruple(OP_LABEL, NULL, NULL, false_label);
+    add_quadruple(OP_ASSIGN, "false", NULL, temp);
+    add_quadruple(OP_LABEL, NULL, NULL, end_label);
+
+    free(true_label);
+    free(false_label);
+    free(end_label);
+    e->type = BOOL_TYPE;
+    e->temp_var = temp;
+    e->truelist = NULL;
+    e->falselist = NULL;
 }
 
 
@@ -155,8 +274,10 @@ char *default_label = NULL;
     char c;
     float f;
     char *s;
+    ValueType type;
     expr expr;
     Parameter *param_list;
+    NameList *name_list;
     struct {
         char *code;     
         char *true_label;
@@ -181,17 +302,19 @@ char *default_label = NULL;
 %token <f> FLOAT
 %token <c> CHAR
 %token <i> BOOLEAN
-%token <s> IDENTIFIER TYPE STRING
+%token <s> IDENTIFIER STRING
+%token <type> TYPE
 %token UNKNOWN
 %token INC DEC
 
-%type <expr> expression logical_expr logical_term equality_expr relational_expr additive_expr multiplicative_expr exponent_expr unary_expr primary_expr function_call
+%type <expr> expression condition logical_expr logical_term equality_expr relational_expr additive_expr multiplicative_expr exponent_expr unary_expr primary_expr function_call
 %type <param_list> params param_list param
-%type <s> identifier_list
+%type <name_list> identifier_list
+%type <s> for_cond_label
 %type <code_info> if_stmt else_part while_stmt while_header for_stmt switch_stmt repeat_stmt for_header for_body
 %type <expr> CONSTANT_VAL
 %type <void_val> statement_list case_list default_case
-%type <param_list> argument_list
+%type <i> argument_list
 
 /* Define operator precedence */
 %left OR
@@ -212,7 +335,19 @@ char *default_label = NULL;
 /* Grammar Rules */
 
 program:
-    statement_list
+    top_level_list
+    ;
+
+/* Same as statement_list, but each complete top-level statement or
+   function can be flushed right away in streaming mode */
+top_level_list:
+    /* empty */
+    | top_level_list statement {
+        if (stream_active()) {
+            currentFunction = NULL;  // may live in a scope about to be released
+            stream_flush();
+        }
+    }
     ;
 
 statement_list:
@@ -280,34 +415,26 @@ statement:
 
 declaration:
     TYPE identifier_list {
-        int count = 0;
-        char** result = split($2, ",", &count);
-        if (result) {
-            Value myvalue;
-            myvalue.iVal = 0;
-            for (int i = 0; i < count; i++) {
-                if (isSymbolDeclaredInCurrentScope(result[i])) {
-                    report_error(SEMANTIC_ERROR, "Variable Redeclaration", prev_valid_line);
-                    fprintf(stderr, "Semantic Error (line %d): Variable '%s' already declared in this scope.\n", prev_valid_line, result[i]);
-                } else {
-                    addSymbol(result[i], $1, false, myvalue, false, false, NULL);
-                }
+        Value myvalue;
+        myvalue.iVal = 0;
+        for (int i = 0; i < $2->count; i++) {
+            const char *name = $2->names[i];
+            if (isSymbolDeclaredInCurrentScope(name)) {
+                report_diagnostic(SEMANTIC_ERROR, "Variable Redeclaration", prev_valid_line, name, "Variable '%s' already declared in this scope.", name);
+            } else {
+                addSymbol(name, $1, false, myvalue, false, false, NULL);
             }
-            free_split_result(result, count);
-        } else {
-            printf("Error splitting string\n");
         }
+        freeNameList($2);
     }
     | TYPE IDENTIFIER ASSIGN expression {
         if (isSymbolDeclaredInCurrentScope($2)) {
-            report_error(SEMANTIC_ERROR, "Variable Redeclaration", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' already declared in this scope.\n", prev_valid_line, $2);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Redeclaration", prev_valid_line, $2, "Variable '%s' already declared in this scope.", $2);
         } else {
             addSymbol($2, $1, true, $4.value, false, false, NULL);
-            ValueType declaredType = mapStringToValueType($1);
+            ValueType declaredType = $1;
             if (!areTypesCompatible(declaredType, $4.type)) {
-                report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-                fprintf(stderr, "Semantic Error (line %d): Incompatible type assignment to variable '%s'.\n", prev_valid_line, $2);
+                report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, $2, "Incompatible type assignment to variable '%s'.", $2);
             } else {
                 char *expr_result;
                 if ($4.temp_var) {
@@ -347,10 +474,13 @@ declaration:
     ;
 
 identifier_list:
-    IDENTIFIER
-    {$$ = $1;}
+    IDENTIFIER {
+        $$ = createNameList(internName($1));
+        free($1);
+    }
     | identifier_list COMMA IDENTIFIER {
-        $$ = concat_with_comma($1,$3);
+        $$ = appendName($1, internName($3));
+        free($3);
     }
     | identifier_list COMMA error {
         report_error(SYNTAX_ERROR, "Expected an identifier", prev_valid_line);
@@ -362,13 +492,12 @@ assignment:
     IDENTIFIER INC {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry) {
-            report_error(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' used before declaration.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $1, "Variable '%s' used before declaration.", $1);
             // YYABORT;
         } 
         else {
             if (!entry->isInitialized) {
-                fprintf(stderr, "Semantic Warning (line %d): Variable '%s' used before initialization.\n", prev_valid_line, $1);
+                report_diagnostic(SEMANTIC_WARNING, "Uninitialized Variable", prev_valid_line, $1, "Variable '%s' used before initialization.", $1);
             }
             handleInc($1);
             add_quadruple(OP_INC, $1, NULL, $1);
@@ -377,13 +506,12 @@ assignment:
     | IDENTIFIER DEC {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry) {
-            report_error(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' used before declaration.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $1, "Variable '%s' used before declaration.", $1);
             // YYABORT;
         } 
         else {
             if (!entry->isInitialized) {
-                fprintf(stderr, "Semantic Warning (line %d): Variable '%s' used before initialization.\n", prev_valid_line, $1);
+                report_diagnostic(SEMANTIC_WARNING, "Uninitialized Variable", prev_valid_line, $1, "Variable '%s' used before initialization.", $1);
             }
             handleDec($1);
             add_quadruple(OP_DEC, $1, NULL, $1);
@@ -392,13 +520,12 @@ assignment:
     | INC IDENTIFIER {
         SymbolTableEntry *entry = lookupSymbol($2);
         if (!entry) {
-            report_error(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' used before declaration.\n", prev_valid_line, $2);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $2, "Variable '%s' used before declaration.", $2);
             // YYABORT;
         } 
         else {
             if (!entry->isInitialized) {
-                fprintf(stderr, "Semantic Warning (line %d): Variable '%s' used before initialization.\n", prev_valid_line, $2);
+                report_diagnostic(SEMANTIC_WARNING, "Uninitialized Variable", prev_valid_line, $2, "Variable '%s' used before initialization.", $2);
             }
             handleInc($2);
             add_quadruple(OP_INC, $2, NULL, $2);
@@ -407,13 +534,12 @@ assignment:
     | DEC IDENTIFIER {
         SymbolTableEntry *entry = lookupSymbol($2);
         if (!entry) {
-            report_error(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' used before declaration.\n", prev_valid_line, $2);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $2, "Variable '%s' used before declaration.", $2);
             // YYABORT;
         } 
         else {
             if (!entry->isInitialized) {
-                fprintf(stderr, "Semantic Warning (line %d): Variable '%s' used before initialization.\n", prev_valid_line, $2);
+                report_diagnostic(SEMANTIC_WARNING, "Uninitialized Variable", prev_valid_line, $2, "Variable '%s' used before initialization.", $2);
             }
             handleDec($2);
             add_quadruple(OP_DEC, $2, NULL, $2);
@@ -422,12 +548,10 @@ assignment:
     | IDENTIFIER ASSIGN expression {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry) {
-            report_error(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' used before declaration.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $1, "Variable '%s' used before declaration.", $1);
         } else {
             if (!areTypesCompatible(entry->type, $3.type)) {
-                report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-                fprintf(stderr, "Semantic Error (line %d): Incompatible type assignment to variable '%s'.\n", prev_valid_line, $1);
+                report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, $1, "Incompatible type assignment to variable '%s'.", $1);
             }
             else {
                 Value myValue = $3.value;
@@ -478,30 +602,14 @@ assignment:
     ;
 
 if_stmt:
-    IF LPAREN expression RPAREN {
+    IF LPAREN condition RPAREN {
         char *true_label = new_label();
         char *false_label = new_label();
         char *next_label = new_label();
 
-        expr condition = $3;
-        convert_to_bool_if_needed(&condition);
-
-        if (condition.temp_var) {
-            add_quadruple(OP_IFGOTO, condition.temp_var, NULL, true_label);
-        } else {
-            char expr_result[50];
-            switch (condition.type) {
-                case INT_TYPE:   sprintf(expr_result, "%d", condition.value.iVal); break;
-                case FLOAT_TYPE: sprintf(expr_result, "%f", condition.value.fVal); break;
-                case BOOL_TYPE:  sprintf(expr_result, "%s", condition.value.bVal ? "true" : "false"); break;
-                default:         strcpy(expr_result, "unknown");
-            }
-            add_quadruple(OP_IFGOTO, expr_result, NULL, true_label);
-        }
-
         // Jump to else block if condition is false
-        add_quadruple(OP_GOTO, NULL, NULL, false_label);
-        add_quadruple(OP_LABEL, NULL, NULL, true_label);
+        emit_fallthrough_label(&$3, 1, true_label);
+        backpatch($3.falselist, false_label);
 
         $<code_info>$ = (typeof($<code_info>$)){
             .true_label = true_label,
@@ -533,11 +641,11 @@ if_stmt:
         report_error(SYNTAX_ERROR, "Expected '(' in if condition", prev_valid_line);
         yyerrok;
     }
-    | IF LPAREN expression error {
+    | IF LPAREN condition error {
         report_error(SYNTAX_ERROR, "Expected ')' in if condition", prev_valid_line);
         yyerrok;
     }
-    | IF LPAREN expression RPAREN error {
+    | IF LPAREN condition RPAREN error {
         report_error(SYNTAX_ERROR, "Malformed if statement", prev_valid_line);
         yyerrok;
     }
@@ -559,30 +667,10 @@ else_part:
     ;
 
 while_stmt:
-    WHILE while_header LPAREN expression {
-        // Evaluate and convert condition
-        expr condition = $<expr>4;
-        convert_to_bool_if_needed(&condition);
-
-        // Emit condition label
-        add_quadruple(OP_LABEL, NULL, NULL, $<code_info>2.cond_label);
-
-        if (condition.temp_var) {
-            add_quadruple(OP_IFGOTO, condition.temp_var, NULL, $<code_info>2.body_label);
-        } else {
-            char buffer[50];
-            switch (condition.type) {
-                case INT_TYPE:   sprintf(buffer, "%d", condition.value.iVal); break;
-                case FLOAT_TYPE: sprintf(buffer, "%f", condition.value.fVal); break;
-                case BOOL_TYPE:  sprintf(buffer, "%s", condition.value.bVal ? "true" : "false"); break;
-                default:         strcpy(buffer, "unknown");
-            }
-            add_quadruple(OP_IFGOTO, buffer, NULL, $<code_info>2.body_label);
-        }
-
+    WHILE while_header LPAREN condition {
         // Labels were created earlier and stored in $<code_info>2
-        add_quadruple(OP_GOTO, NULL, NULL, $<code_info>2.end_label);
-        add_quadruple(OP_LABEL, NULL, NULL, $<code_info>2.body_label);
+        emit_fallthrough_label(&$4, 1, $<code_info>2.body_label);
+        backpatch($4.falselist, $<code_info>2.end_label);
     } RPAREN LBRACE { enterScope(); } statement_list RBRACE {
         exitScope();
 
@@ -603,7 +691,7 @@ while_stmt:
         report_error(SYNTAX_ERROR, "Expected '(' in while condition", prev_valid_line);
         yyerrok;
     }
-    | WHILE while_header LPAREN expression error LBRACE { enterScope(); } statement_list RBRACE {
+    | WHILE while_header LPAREN condition error LBRACE { enterScope(); } statement_list RBRACE {
         exitScope();
         report_error(SYNTAX_ERROR, "Expected ')' in while condition", prev_valid_line);
         yyerrok;
@@ -617,6 +705,9 @@ while_header:
         char *body_label  = new_label();
         char *end_label  = new_label();
 
+        // The condition is evaluated again on every iteration
+        add_quadruple(OP_LABEL, NULL, NULL, cond_label);
+
         // Pass all labels
         $$.cond_label  = cond_label;
         $$.body_label  = body_label;
@@ -655,24 +746,14 @@ for_stmt:
 ;
 
 for_header:
-    for_stmt_declaration SEMI expression SEMI
+    for_stmt_declaration SEMI for_cond_label condition SEMI
     {
-        char *cond_label = new_label();
+        char *cond_label = $3;
         char *body_label = new_label();
         char *end_label  = new_label();
 
-        add_quadruple(OP_LABEL, NULL, NULL, cond_label);
-
-        if ($3.temp_var) {
-            add_quadruple(OP_IFGOTO, $3.temp_var, NULL, body_label);
-        } else {
-            char buffer[50];
-            sprintf(buffer, "%d", $3.value.iVal);
-            add_quadruple(OP_IFGOTO, buffer, NULL, body_label);
-        }
-
-        add_quadruple(OP_GOTO, NULL, NULL, end_label);
-        add_quadruple(OP_LABEL, NULL, NULL, body_label);
+        emit_fallthrough_label(&$4, 1, body_label);
+        backpatch($4.falselist, end_label);
 
         // Pass info to for_body
         $$.cond_label = cond_label;
@@ -685,7 +766,7 @@ for_header:
         report_error(SYNTAX_ERROR, "Expected ';'", prev_valid_line);
         yyerrok;
     }
-    | for_stmt_declaration SEMI expression error {
+    | for_stmt_declaration SEMI for_cond_label condition error {
         report_error(SYNTAX_ERROR, "Expected ';'", prev_valid_line);
         yyerrok;
     }
@@ -695,6 +776,14 @@ for_header:
     }
     ;
 
+for_cond_label:
+    /* empty */ {
+        // Emitted before the condition so the loop re-evaluates it
+        $$ = new_label();
+        add_quadruple(OP_LABEL, NULL, NULL, $$);
+    }
+    ;
+
 for_body:
     LBRACE statement_list RBRACE {}
 ;
@@ -795,7 +884,7 @@ CONSTANT_VAL:
     | IDENTIFIER {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry) {
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' not declared.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $1, "Variable '%s' not declared.", $1);
             YYABORT;
         }
         $$ = (expr){.type = entry->type, .value = entry->value, .temp_var = strdup($1)};
@@ -841,7 +930,6 @@ case_list:
 
 case_item:
     CASE CONSTANT_VAL COLON {
-        char *case_label = new_label();
         char *next_case_label = new_label();
         char *val_str = malloc(50);
 
@@ -854,13 +942,8 @@ case_item:
             default:          strcpy(val_str, "unknown");
         }
 
-        char *temp = new_temp();
-        add_quadruple(OP_EQ, current_switch_var, val_str, temp);
-
-        // if t goto case_label, else goto next
-        add_quadruple(OP_IFGOTO, temp, NULL, case_label);
-        add_quadruple(OP_GOTO, NULL, NULL, next_case_label);
-        add_quadruple(OP_LABEL, NULL, NULL, case_label);
+        // skip to the next case unless the value matches
+        add_quadruple(OP_IF_NEQ, current_switch_var, val_str, next_case_label);
 
         current_case_next_label = next_case_label;
         free(val_str);
@@ -882,6 +965,7 @@ default_case:
     DEFAULT COLON {
         default_label = new_label();
         add_quadruple(OP_LABEL, NULL, NULL, default_label);
+        mark_cold_label(default_label);
     } statement_list {
         add_quadruple(OP_GOTO, NULL, NULL, current_switch_end_label);
     }
@@ -897,14 +981,14 @@ return_stmt:
         return_seen = 1; 
         /* Generate return quadruple */
         if (currentFunctionReturnType == VOID_TYPE) {
-            report_error(SEMANTIC_ERROR, "Void Function Return Value", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Void function '%s' should not return a value.\n",
-                    prev_valid_line,
+            report_diagnostic(SEMANTIC_ERROR, "Void Function Return Value", prev_valid_line,
+                    currentFunction ? currentFunction->identifierName : "unknown",
+                    "Void function '%s' should not return a value.",
                     currentFunction ? currentFunction->identifierName : "unknown");
         } else if (!areTypesCompatible(currentFunctionReturnType, $2.type)) {
-            report_error(SEMANTIC_ERROR, "Return Type Mismatch", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Return type mismatch in function '%s'.\n",
-                    prev_valid_line,
+            report_diagnostic(SEMANTIC_ERROR, "Return Type Mismatch", prev_valid_line,
+                    currentFunction ? currentFunction->identifierName : "unknown",
+                    "Return type mismatch in function '%s'.",
                     currentFunction ? currentFunction->identifierName : "unknown");
         }
         if ($2.temp_var) {
@@ -939,9 +1023,9 @@ return_stmt:
     | RETURN {
         return_seen = 1; 
         if (currentFunctionReturnType != VOID_TYPE) {
-            report_error(SEMANTIC_ERROR, "Missing Return Value", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Function '%s' must return a value (void).\n",
-                    prev_valid_line,
+            report_diagnostic(SEMANTIC_ERROR, "Missing Return Value", prev_valid_line,
+                    currentFunction ? currentFunction->identifierName : "unknown",
+                    "Function '%s' must return a value (void).",
                     currentFunction ? currentFunction->identifierName : "unknown");
         }
         /* Generate empty return quadruple */
@@ -950,93 +1034,58 @@ return_stmt:
     ;
 
 expression:
-    logical_expr { $$ = $1; }
+    logical_expr {
+        $$ = $1;
+        materialize_bool(&$$);
+    }
     ;
 
-logical_expr:
-    logical_expr OR logical_term {
-        convert_to_bool_if_needed(&$1);
-        convert_to_bool_if_needed(&$3);
+condition:
+    logical_expr {
+        $$ = $1;
+        make_jumping(&$$);
+    }
+    ;
 
-        char *temp = new_temp();
-        if ($1.temp_var && $3.temp_var) {
-            add_quadruple(OP_OR, $1.temp_var, $3.temp_var, temp);
-        } else {
-            char *arg1 = $1.temp_var ? $1.temp_var : malloc(50);
-            char *arg2 = $3.temp_var ? $3.temp_var : malloc(50);
-            
-            if (!$1.temp_var) {
-                switch ($1.type) {
-                    case INT_TYPE: sprintf(arg1, "%d", $1.value.iVal); break;
-                    case FLOAT_TYPE: sprintf(arg1, "%f", $1.value.fVal); break;
-                    case BOOL_TYPE: sprintf(arg1, "%s", $1.value.bVal ? "true" : "false"); break;
-                    default: strcpy(arg1, "unknown");
-                }
-            }
-            
-            if (!$3.temp_var) {
-                switch ($3.type) {
-                    case INT_TYPE: sprintf(arg2, "%d", $3.value.iVal); break;
-                    case FLOAT_TYPE: sprintf(arg2, "%f", $3.value.fVal); break;
-                    case BOOL_TYPE: sprintf(arg2, "%s", $3.value.bVal ? "true" : "false"); break;
-                    default: strcpy(arg2, "unknown");
-                }
-            }
-            
-            add_quadruple(OP_OR, arg1, arg2, temp);
-            
-            if (!$1.temp_var) free(arg1);
-            if (!$3.temp_var) free(arg2);
-        }
-        
+logical_expr:
+    logical_expr OR {
+        // Evaluate the right operand only when the left one is false
+        make_jumping(&$1);
+        char *right_label = new_label();
+        emit_fallthrough_label(&$1, 0, right_label);
+        free(right_label);
+    } logical_term {
+        make_jumping(&$4);
         $$.type = BOOL_TYPE;
-        $$.value.bVal = true;
-        $$.temp_var = temp;
+        $$.temp_var = NULL;
+        $$.truelist = merge($1.truelist, $4.truelist);
+        $$.falselist = $4.falselist;
     }
     | logical_term { $$ = $1; }
     ;
 
 logical_term:
-    logical_term AND equality_expr {
-        convert_to_bool_if_needed(&$1);
-        convert_to_bool_if_needed(&$3);
-        
-        char *temp = new_temp();
-        if ($1.temp_var && $3.temp_var) {
-            add_quadruple(OP_AND, $1.temp_var, $3.temp_var, temp);
-        } else {
-            char *arg1 = $1.temp_var ? $1.temp_var : malloc(50);
-            char *arg2 = $3.temp_var ? $3.temp_var : malloc(50);
-            
-            if (!$1.temp_var) {
-                switch ($1.type) {
-                    case INT_TYPE: sprintf(arg1, "%d", $1.value.iVal); break;
-                    case FLOAT_TYPE: sprintf(arg1, "%f", $1.value.fVal); break;
-                    case BOOL_TYPE: sprintf(arg1, "%s", $1.value.bVal ? "true" : "false"); break;
-                    default: strcpy(arg1, "unknown");
-                }
-            }
-            
-            if (!$3.temp_var) {
-                switch ($3.type) {
-                    case INT_TYPE: sprintf(arg2, "%d", $3.value.iVal); break;
-                    case FLOAT_TYPE: sprintf(arg2, "%f", $3.value.fVal); break;
-                    case BOOL_TYPE: sprintf(arg2, "%s", $3.value.bVal ? "true" : "false"); break;
-                    default: strcpy(arg2, "unknown");
-                }
-            }
-            
-            add_quadruple(OP_AND, arg1, arg2, temp);
-            
-            if (!$1.temp_var) free(arg1);
-            if (!$3.temp_var) free(arg2);
-        }
-        
+    logical_term AND {
+        // Evaluate the right operand only when the left one is true
+        make_jumping(&$1);
+        char *right_label = new_label();
+        emit_fallthrough_label(&$1, 1, right_label);
+        free(right_label);
+    } equality_expr {
+        // equality_expr builds no jump lists, clear whatever $4 was copied from
+        $4.truelist = NULL;
+        $4.falselist = NULL;
+        make_jumping(&$4);
         $$.type = BOOL_TYPE;
-        $$.value.bVal = true;
-        $$.temp_var = temp;
+        $$.temp_var = NULL;
+        $$.truelist = $4.truelist;
+        $$.falselist = merge($1.falselist, $4.falselist);
+    }
+    | equality_expr {
+        $$ = $1;
+        $$.truelist = NULL;
+        $$.falselist = NULL;
     }
-    | equality_expr { $$ = $1; }
     ;
 
 equality_expr:
@@ -1276,8 +1325,7 @@ relational_expr:
 additive_expr:
     additive_expr PLUS multiplicative_expr {
         if (!areTypesCompatible($1.type, $3.type)) {
-            report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Incompatible types in addition.\n", prev_valid_line);
+            report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, NULL, "Incompatible types in addition.");
         }
         else
         {
@@ -1331,8 +1379,7 @@ additive_expr:
     }
     | additive_expr MINUS multiplicative_expr {
         if (!areTypesCompatible($1.type, $3.type)) {
-            report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Incompatible types in subtraction.\n", prev_valid_line);
+            report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, NULL, "Incompatible types in subtraction.");
         }
         else
         {
@@ -1392,8 +1439,7 @@ additive_expr:
 multiplicative_expr:
     multiplicative_expr MUL exponent_expr {
         if (!areTypesCompatible($1.type, $3.type)) {
-            report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Incompatible types in multiplication.\n", prev_valid_line);
+            report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, NULL, "Incompatible types in multiplication.");
         }
         else
         {
@@ -1447,15 +1493,14 @@ multiplicative_expr:
     }
     | multiplicative_expr DIV exponent_expr {
         if (!areTypesCompatible($1.type, $3.type)) {
-            report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Incompatible types in division.\n", prev_valid_line);
+            report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, NULL, "Incompatible types in division.");
         }
         else
         {
             /* Check for division by zero */
             if (($3.type == INT_TYPE && $3.value.iVal == 0) || 
                 ($3.type == FLOAT_TYPE && $3.value.fVal == 0.0)) {
-                fprintf(stderr, "Semantic Error (line %d): Division by zero.\n", prev_valid_line);
+                report_diagnostic(SEMANTIC_ERROR, "Division By Zero", prev_valid_line, NULL, "Division by zero.");
             }
             else
             {
@@ -1514,7 +1559,7 @@ multiplicative_expr:
         /* Check for modulo by zero */
         if (($3.type == INT_TYPE && $3.value.iVal == 0) || 
             ($3.type == FLOAT_TYPE && $3.value.fVal == 0.0)) {
-            fprintf(stderr, "Semantic Error (line %d): Modulo by zero.\n", prev_valid_line);
+            report_diagnostic(SEMANTIC_ERROR, "Division By Zero", prev_valid_line, NULL, "Modulo by zero.");
         }
         
         /* Generate quadruple for modulo */
@@ -1566,8 +1611,7 @@ multiplicative_expr:
 exponent_expr:
     exponent_expr EXP unary_expr {
         if (!areTypesCompatible($1.type, $3.type)) {
-            report_error(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Incompatible types in exponentiation.\n", prev_valid_line);
+            report_diagnostic(SEMANTIC_ERROR, "Incompatible Types", prev_valid_line, NULL, "Incompatible types in exponentiation.");
         }
         else
         {
@@ -1715,13 +1759,12 @@ primary_expr:
     | IDENTIFIER {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry) {
-            report_error(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Variable '%s' used before declaration.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Variable Undeclared", prev_valid_line, $1, "Variable '%s' used before declaration.", $1);
             // YYABORT;
         }
         else {
             if (!entry->isInitialized  && !entry->isFunction) {
-                fprintf(stderr, "Semantic Warning (line %d): Variable '%s' used before initialization.\n", prev_valid_line, $1);
+                report_diagnostic(SEMANTIC_WARNING, "Uninitialized Variable", prev_valid_line, $1, "Variable '%s' used before initialization.", $1);
             }
             entry->isUsed = true;
             $$ = (expr){.type = entry->type, .value = entry->value, .temp_var = strdup($1)};
@@ -1740,31 +1783,13 @@ repeat_stmt:
 
         $<code_info>$.code = start_label;
         $<code_info>$.end_label = end_label;     
-    } statement_list RBRACE UNTIL LPAREN expression RPAREN SEMI {
+    } statement_list RBRACE UNTIL LPAREN condition RPAREN SEMI {
         exitScope();
         pop_loop_labels(); 
 
-        expr condition = $8;
-        convert_to_bool_if_needed(&condition);
-
-        // If expression has a temp variable
-        if (condition.temp_var) {
-            add_quadruple(OP_IFGOTO, condition.temp_var, NULL, $<code_info>3.end_label);
-        } else {
-            char *expr_result = malloc(50);
-            switch (condition.type) {
-                case INT_TYPE:   sprintf(expr_result, "%d", condition.value.iVal); break;
-                case FLOAT_TYPE: sprintf(expr_result, "%f", condition.value.fVal); break;
-                case BOOL_TYPE:  sprintf(expr_result, "%s", condition.value.bVal ? "true" : "false"); break;
-                default:         strcpy(expr_result, "unknown");
-            }
-            add_quadruple(OP_IFGOTO, expr_result, NULL, $<code_info>3.end_label);
-            free(expr_result);
-        }
-
-        // Jump back to start of loop
-        add_quadruple(OP_GOTO, NULL, NULL, $<code_info>3.code);
-        add_quadruple(OP_LABEL, NULL, NULL, $<code_info>3.end_label);
+        // Leave the loop once the condition holds, otherwise jump back to the start
+        emit_fallthrough_label(&$8, 1, $<code_info>3.end_label);
+        backpatch($8.falselist, $<code_info>3.code);
 
         // Clean up
         free($<code_info>3.code);
@@ -1780,23 +1805,28 @@ function_decl:
     FUNCTION TYPE IDENTIFIER LPAREN params RPAREN LBRACE {
         Value myValue;
         myValue.iVal = 0;
-        addSymbol($3, $2, true, myValue, false, true, $5); 
+        SymbolTableEntry *fn = addSymbol($3, $2, true, myValue, false, true, $5); 
         enterScope();
         currentFunction = lookupSymbol($3);
-        currentFunctionReturnType = mapStringToValueType($2);
+        currentFunctionReturnType = $2;
         return_seen = 0;
         caught = 0;
         addParamsToSymbolTable($5);
+        freeParameterList($5);  // the symbol table keeps its own copy
+        if (fn) fn->quadStart = quad_count;
         add_quadruple(OP_LABEL, NULL, NULL, $3);
+        $<void_val>$ = fn;
     } statement_list RBRACE {
         /* Generate implicit return if none exists */
         if (currentFunctionReturnType != VOID_TYPE && !return_seen && !caught) {
-            report_error(SEMANTIC_ERROR, "Missing Return Statement", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Function '%s' is missing a return statement.\n",
-                    prev_valid_line,
+            report_diagnostic(SEMANTIC_ERROR, "Missing Return Statement", prev_valid_line,
+                    currentFunction ? currentFunction->identifierName : "unknown",
+                    "Function '%s' is missing a return statement.",
                     currentFunction ? currentFunction->identifierName : "unknown");
         }
         add_quadruple(OP_RETURN, NULL, NULL, NULL);
+        SymbolTableEntry *fn = $<void_val>8;
+        if (fn) fn->quadEnd = quad_count;
         exitScope();
     }
     | FUNCTION error IDENTIFIER LPAREN params RPAREN LBRACE statement_list RBRACE {
@@ -1830,14 +1860,12 @@ function_call:
     IDENTIFIER LPAREN argument_list RPAREN {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry || !entry->isFunction) {
-            report_error(SEMANTIC_ERROR, "Invalid Function Call", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Function '%s' is not declared.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Invalid Function Call", prev_valid_line, $1, "Function '%s' is not declared.", $1);
             $$ = (expr){.type = INT_TYPE, .temp_var = new_temp()};  
         } else {
             entry->isUsed = true;
-            if (!compareParameters(entry->params, $3)) {
-                report_error(SEMANTIC_ERROR, "Function Argument Mismatch", prev_valid_line);
-                fprintf(stderr, "Semantic Error (line %d): Arguments passed to function '%s' do not match its definition.\n", prev_valid_line, $1);
+            if (entry->signature != $3) {
+                report_diagnostic(SEMANTIC_ERROR, "Function Argument Mismatch", prev_valid_line, $1, "Arguments passed to function '%s' do not match its definition.", $1);
             }
 
             char *result = new_temp();
@@ -1851,14 +1879,12 @@ function_call:
     | IDENTIFIER LPAREN RPAREN {
         SymbolTableEntry *entry = lookupSymbol($1);
         if (!entry || !entry->isFunction) {
-            report_error(SEMANTIC_ERROR, "Invalid Function Call", prev_valid_line);
-            fprintf(stderr, "Semantic Error (line %d): Function '%s' is not declared.\n", prev_valid_line, $1);
+            report_diagnostic(SEMANTIC_ERROR, "Invalid Function Call", prev_valid_line, $1, "Function '%s' is not declared.", $1);
             $$ = (expr){.type = INT_TYPE, .temp_var = new_temp()};  
         } else {
             entry->isUsed = true;
-            if (entry->params != NULL) {
-                report_error(SEMANTIC_ERROR, "Function Argument Mismatch", prev_valid_line);
-                fprintf(stderr, "Semantic Error (line %d): Function '%s' expects arguments.\n", prev_valid_line, $1);
+            if (entry->signature != EMPTY_SIGNATURE) {
+                report_diagnostic(SEMANTIC_ERROR, "Function Argument Mismatch", prev_valid_line, $1, "Function '%s' expects arguments.", $1);
             }
 
             char *result = new_temp();
@@ -1877,9 +1903,7 @@ function_call:
 
 argument_list:
     argument_list COMMA expression {
-        const char* t = typeToString($3.type);
-        Parameter* arg = createParameter("arg", strdup(t));
-        $$ = addParameter($1, arg);
+        $$ = extendSignature($1, $3.type);
         /* Generate parameter passing quadruple */
         if ($3.temp_var) {
             add_quadruple(OP_PARAM, $3.temp_var, NULL, NULL);
@@ -1899,8 +1923,7 @@ argument_list:
         }
     }
     | expression {
-        const char* t = typeToString($1.type);
-        $$ = createParameter("arg", strdup(t));
+        $$ = extendSignature(EMPTY_SIGNATURE, $1.type);
         /* Generate parameter passing quadruple */
         if ($1.temp_var) {
             add_quadruple(OP_PARAM, $1.temp_var, NULL, NULL);
@@ -1970,8 +1993,7 @@ const_decl:
         addSymbol($3, $2, true, myValue, true, false, NULL);
     }
     | CONST IDENTIFIER ASSIGN expression {
-        report_error(SEMANTIC_ERROR, "Missing Type", prev_valid_line);
-        fprintf(stderr, "Semantic Error (line %d): Constant '%s' declared without a type.\n", prev_valid_line, $2);
+        report_diagnostic(SEMANTIC_ERROR, "Missing Type", prev_valid_line, $2, "Constant '%s' declared without a type.", $2);
     }
     ;
 
@@ -1982,56 +2004,94 @@ void yyerror(const char *s) {
     
 }
 
-int main() {
+int main(int argc, char **argv) {
+    const char *input_path = NULL;
+    int streaming = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+            set_max_errors(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            streaming = 1;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            if (load_block_profile(argv[++i]) != 0) {
+                printf("Failed to read profile %s\n", argv[i]);
+            }
+        } else if (strncmp(argv[i], "--", 2) != 0 && !input_path) {
+            input_path = argv[i];
+        } else {
+            printf("Usage: %s [--max-errors N] [--stream] [--profile FILE] [input file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!input_path) {
+        input_path = "test/input.txt";
+    }
+
     printf("Starting parser...\n");
     initSymbolTable();
+    open_diagnostics("diagnostics.jsonl");
     fclose(fopen("quadruples.txt", "w"));
     fclose(fopen("output.asm", "w"));
-    FILE *input = fopen("test/input.txt", "r");
+    FILE *input = fopen(input_path, "r");
     if (input) {
         yyin = input;
         yylineno = 1;
+        if (streaming) {
+            stream_begin("quadruples.txt", "output.asm", "symbol_table.txt");
+        }
         yyparse();
         checkUnclosedScopes(yylineno);
         printf("\n=== Parsing Finished ===\n");
-        print_all_errors();  
         reportUnusedVariables();
+        print_all_errors();
         if (get_error_count() > 0) {
             printf("Parsing failed with errors.\n");
         } else {
             printf("Parsing successful!\n");
+        }
+        if (streaming) {
+            // Code and local scopes were written as they were parsed,
+            // only the tail and the global scope are left
+            stream_end();
+        } else if (get_error_count() == 0) {
+            int inlined = inline_functions();
+            if (inlined > 0) {
+                printf("Inlined %d call site(s)\n", inlined);
+            }
+            convert_tail_calls();
+            global_value_numbering(1);
+            LayoutStats layout = { 0, 0 };
+            layout_blocks(&layout, 1);
+            printf("Taken jumps (estimated): %.1f before block layout, %.1f after\n",
+                   layout.takenBefore, layout.takenAfter);
             // Write quadruples to file
             FILE *quad_output = fopen("quadruples.txt", "w");
             if (quad_output) {
-                fprintf(quad_output, "=== Generated Quadruples ===\n");
-                for (int i = 0; i < quad_count; i++) {
-                    fprintf(quad_output, "[%d] (%s, %s, %s, %s)\n", i,
-                        get_op_string(quadruples[i].op),
-                        quadruples[i].arg1 ? quadruples[i].arg1 : "_",
-                        quadruples[i].arg2 ? quadruples[i].arg2 : "_",
-                        quadruples[i].result ? quadruples[i].result : "_"
-                    );
-                }
+                write_quadruples_text(quad_output);
                 fclose(quad_output);
                 printf("Quadruples written to quadruples.txt\n");
             }
+            if (write_quadruples_binary("quadruples.qir") == 0) {
+                printf("Binary quadruples written to quadruples.qir\n");
+            }
 
             // Convert quadruples to assembly
             convert_quadruples_to_assembly("output.asm");
             printf("Assembly code written to output.asm\n");
         }
 
-        FILE *output = fopen("symbol_table.txt", "w");
+        FILE *output = streaming ? NULL : fopen("symbol_table.txt", "w");
         if (output) {
             writeSymbolTableOfAllScopesToFile(output);
             fclose(output);
-        } else {
+        } else if (!streaming) {
             printf("Failed to open symbol_table.txt for writing.\n");
         }
         fclose(input);
-        clearSymbolTables(currentScope);
+        clearSymbolTables();
     } else {
         printf("Failed to open input file.\n");
     }
+    close_diagnostics();
     return 0;
 }
\ No newline at end of file
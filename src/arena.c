@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_ALIGN sizeof(void *)
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static char *chunk_data(ArenaChunk *chunk) {
+    return (char *)chunk + align_up(sizeof(ArenaChunk));
+}
+
+static ArenaChunk *new_chunk(size_t size, ArenaChunk *next) {
+    ArenaChunk *chunk = malloc(align_up(sizeof(ArenaChunk)) + size);
+    if (!chunk) {
+        printf("Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    chunk->next = next;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void arena_init(Arena *arena, size_t chunk_size) {
+    arena->head = NULL;
+    arena->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = align_up(size);
+    if (!arena->head || arena->head->used + size > arena->head->size) {
+        size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+        arena->head = new_chunk(chunk_size, arena->head);
+    }
+    void *ptr = chunk_data(arena->head) + arena->head->used;
+    arena->head->used += size;
+    return ptr;
+}
+
+char *arena_strdup(Arena *arena, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *copy = arena_alloc(arena, len);
+    memcpy(copy, s, len);
+    return copy;
+}
+
+ArenaMark arena_mark(Arena *arena) {
+    ArenaMark mark = { arena->head, arena->head ? arena->head->used : 0 };
+    return mark;
+}
+
+void arena_release(Arena *arena, ArenaMark mark) {
+    while (arena->head && arena->head != mark.chunk) {
+        ArenaChunk *next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    if (arena->head) {
+        arena->head->used = mark.used;
+    }
+}
+
+void arena_reset(Arena *arena) {
+    if (!arena->head) return;
+
+    // Keep the oldest chunk, it is the one sized for the common case
+    ArenaChunk *last = arena->head;
+    while (last->next) {
+        ArenaChunk *next = last->next;
+        free(last);
+        last = next;
+    }
+    last->used = 0;
+    arena->head = last;
+}
+
+void arena_free(Arena *arena) {
+    while (arena->head) {
+        ArenaChunk *next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+}
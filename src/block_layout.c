@@ -0,0 +1,662 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quadruple.h"
+#include "symbol_table.h"
+#include "cfg.h"
+#include "block_layout.h"
+
+// Static branch probabilities, after Ball and Larus. Each one is the
+// probability of the edge it names being taken.
+#define PROB_BACK_EDGE 0.88
+#define PROB_LOOP_EXIT 0.12
+#define PROB_COLD      0.05   // into a cold label such as a switch default
+#define PROB_RETURN    0.28   // into a block that returns, usually an early exit
+#define PROB_EQUAL     0.30   // equality rarely holds
+
+// Chains whose head runs less often than this fraction of the entry are
+// placed after all the others
+#define COLD_FRACTION 0.1
+
+#define MAX_FREQUENCY_ROUNDS 200
+
+typedef struct {
+    char *label;
+    double count;
+} ProfileEntry;
+
+// Open addressing on the label, empty slots have a NULL label
+static ProfileEntry *profile = NULL;
+static int profileSize = 0;
+static int profileCount = 0;
+
+static char **coldLabels = NULL;
+static int coldCount = 0;
+static int coldCapacity = 0;
+
+static unsigned int hash_label(const char *s) {
+    unsigned int h = 2166136261u;
+    while (*s) {
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    }
+    return h;
+}
+
+static void profile_insert(char *label, double count) {
+    if ((profileCount + 1) * 2 > profileSize) {
+        ProfileEntry *old = profile;
+        int oldSize = profileSize;
+        profileSize = oldSize ? oldSize * 2 : 64;
+        profile = calloc(profileSize, sizeof(ProfileEntry));
+        profileCount = 0;
+        for (int i = 0; i < oldSize; i++) {
+            if (old[i].label) profile_insert(old[i].label, old[i].count);
+        }
+        free(old);
+    }
+
+    int slot = hash_label(label) & (profileSize - 1);
+    while (profile[slot].label) {
+        if (strcmp(profile[slot].label, label) == 0) {
+            profile[slot].count += count;  // repeated labels add up
+            free(label);
+            return;
+        }
+        slot = (slot + 1) & (profileSize - 1);
+    }
+    profile[slot].label = label;
+    profile[slot].count = count;
+    profileCount++;
+}
+
+// Count recorded for label, -1 if the profile does not mention it
+static double profile_count(const char *label) {
+    if (!label || profileCount == 0) return -1;
+    int slot = hash_label(label) & (profileSize - 1);
+    while (profile[slot].label) {
+        if (strcmp(profile[slot].label, label) == 0) return profile[slot].count;
+        slot = (slot + 1) & (profileSize - 1);
+    }
+    return -1;
+}
+
+int load_block_profile(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return -1;
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char label[128];
+        double count;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %lf", label, &count) == 2 && count >= 0) {
+            profile_insert(strdup(label), count);
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+void mark_cold_label(const char *label) {
+    if (!label) return;
+    if (coldCount == coldCapacity) {
+        coldCapacity = coldCapacity ? coldCapacity * 2 : 8;
+        coldLabels = realloc(coldLabels, coldCapacity * sizeof(char *));
+    }
+    coldLabels[coldCount++] = strdup(label);
+}
+
+static int is_cold_label(const char *label) {
+    for (int i = 0; label && i < coldCount; i++) {
+        if (strcmp(coldLabels[i], label) == 0) return 1;
+    }
+    return 0;
+}
+
+// One run of consecutive quads of a region, laid out on its own. Its first
+// block is entered from the code before it and stays first.
+typedef struct {
+    Cfg *cfg;
+    const char **label;  // label at the start of each block, NULL if none
+    int *taken;          // block the jump ending the block goes to, -1 if none or outside
+    int *fall;           // block reached by falling through, -1 if none
+    double *prob;        // probability of the jump ending the block being taken
+    double *freq;        // expected executions per entry into the segment
+    char *dead;          // unreachable blocks, left out of the layout
+    int *pos;            // position of each block in the order being laid out, -1 if left out
+    int *reach;          // falling off the end of a block reaches the positions up to this one
+} Segment;
+
+static Quadruple *tail_quad(Segment *s, int b) {
+    return &quadruples[s->cfg->quads[s->cfg->blocks[b].last - 1]];
+}
+
+static int tail_falls_through(Segment *s, int b) {
+    OpType op = tail_quad(s, b)->op;
+    return op != OP_GOTO && op != OP_RETURN && op != OP_TAILCALL;
+}
+
+static int dominates(Cfg *cfg, int a, int b) {
+    if (a < 0 || cfg->blocks[a].rpo < 0) return 0;
+    for (int x = b; x >= 0; x = cfg->blocks[x].idom) {
+        if (x == a) return 1;
+    }
+    return 0;
+}
+
+// Blocks of the natural loop closed by the back edge from latch to header
+static char *natural_loop(Cfg *cfg, int latch, int header) {
+    char *inLoop = calloc(cfg->blockCount, 1);
+    int *stack = malloc(cfg->blockCount * sizeof(int));
+    int top = 0;
+    inLoop[header] = 1;
+    if (!inLoop[latch]) {
+        inLoop[latch] = 1;
+        stack[top++] = latch;
+    }
+    while (top > 0) {
+        BasicBlock *b = &cfg->blocks[stack[--top]];
+        for (int p = 0; p < b->predCount; p++) {
+            if (!inLoop[b->preds[p]]) {
+                inLoop[b->preds[p]] = 1;
+                stack[top++] = b->preds[p];
+            }
+        }
+    }
+    free(stack);
+    return inLoop;
+}
+
+// Cold blocks start at a cold label, or only hold labels in front of one
+static int is_cold_block(Segment *s, int b) {
+    for (int steps = 0; b >= 0 && steps < s->cfg->blockCount; steps++) {
+        if (is_cold_label(s->label[b])) return 1;
+        BasicBlock *block = &s->cfg->blocks[b];
+        if (block->last - block->first != 1 || tail_quad(s, b)->op != OP_LABEL) return 0;
+        b = s->fall[b];
+    }
+    return 0;
+}
+
+static int returns(Segment *s, int b) {
+    OpType op = tail_quad(s, b)->op;
+    return op == OP_RETURN || op == OP_TAILCALL;
+}
+
+static double static_probability(Segment *s, int b, char **loops, int loopCount) {
+    int t = s->taken[b];
+    int f = s->fall[b];
+
+    if (dominates(s->cfg, t, b)) return PROB_BACK_EDGE;
+    if (dominates(s->cfg, f, b)) return 1 - PROB_BACK_EDGE;
+
+    for (int l = 0; l < loopCount; l++) {
+        if (loops[l][b] && loops[l][t] != loops[l][f]) {
+            return loops[l][t] ? 1 - PROB_LOOP_EXIT : PROB_LOOP_EXIT;
+        }
+    }
+
+    int coldT = is_cold_block(s, t);
+    if (coldT != is_cold_block(s, f)) return coldT ? PROB_COLD : 1 - PROB_COLD;
+
+    int returnsT = returns(s, t);
+    if (returnsT != returns(s, f)) return returnsT ? PROB_RETURN : 1 - PROB_RETURN;
+
+    OpType op = tail_quad(s, b)->op;
+    if (op == OP_IF_EQ) return PROB_EQUAL;
+    if (op == OP_IF_NEQ) return 1 - PROB_EQUAL;
+    return 0.5;
+}
+
+// Profile counts of the blocks, -1 where unknown. A block without a label
+// is entered by falling through, so its count follows from the block
+// before it.
+static double *block_counts(Segment *s) {
+    int n = s->cfg->blockCount;
+    double *count = malloc(n * sizeof(double));
+    for (int b = 0; b < n; b++) {
+        count[b] = profile_count(s->label[b]);
+    }
+    for (int b = 0; b < n; b++) {
+        BasicBlock *block = &s->cfg->blocks[b];
+        if (s->label[b] || block->predCount != 1) continue;
+
+        int p = block->preds[0];
+        if (count[p] < 0) continue;
+        if (s->taken[p] < 0 || s->taken[p] == b) {
+            count[b] = count[p];
+        } else if (count[s->taken[p]] >= 0) {
+            count[b] = count[p] > count[s->taken[p]] ? count[p] - count[s->taken[p]] : 0;
+        }
+    }
+    return count;
+}
+
+static double edge_probability(Segment *s, int from, int to) {
+    if (s->taken[from] == to && s->fall[from] == to) return 1;
+    if (s->taken[from] == to) return s->prob[from];
+    if (s->fall[from] == to) return 1 - s->prob[from];
+    return 0;
+}
+
+static void estimate_frequencies(Segment *s, double entry) {
+    Cfg *cfg = s->cfg;
+    for (int round = 0; round < MAX_FREQUENCY_ROUNDS; round++) {
+        double change = 0;
+        for (int i = 0; i < cfg->orderCount; i++) {
+            int b = cfg->order[i];
+            double freq = b == 0 ? entry : 0;
+            for (int p = 0; p < cfg->blocks[b].predCount; p++) {
+                int pred = cfg->blocks[b].preds[p];
+                freq += s->freq[pred] * edge_probability(s, pred, b);
+            }
+            double diff = freq > s->freq[b] ? freq - s->freq[b] : s->freq[b] - freq;
+            if (diff > change) change = diff;
+            s->freq[b] = freq;
+        }
+        if (change <= entry * 1e-9) break;
+    }
+}
+
+// Unreachable blocks are dropped, unless a jump from outside them (or from
+// outside the segment) still names one of their labels
+static void find_dead_blocks(Segment *s, int first, int count) {
+    Cfg *cfg = s->cfg;
+    int n = cfg->blockCount;
+    char *inDead = calloc(count, 1);
+    int *stack = malloc(n * sizeof(int));
+    int top = 0;
+
+    for (int b = 0; b < n; b++) {
+        s->dead[b] = cfg->blocks[b].rpo < 0;
+        for (int pos = cfg->blocks[b].first; s->dead[b] && pos < cfg->blocks[b].last; pos++) inDead[pos] = 1;
+    }
+    for (int b = 0; b < n; b++) {
+        if (!s->dead[b] || !s->label[b]) continue;
+        for (int i = 0; i < quad_count; i++) {
+            if (i >= first && i < first + count && inDead[i - first]) continue;
+            const char *target = jump_target(i);
+            if (target && strcmp(target, s->label[b]) == 0) {
+                s->dead[b] = 0;
+                stack[top++] = b;
+                break;
+            }
+        }
+    }
+    while (top > 0) {
+        BasicBlock *block = &cfg->blocks[stack[--top]];
+        for (int i = 0; i < block->succCount; i++) {
+            if (s->dead[block->succ[i]]) {
+                s->dead[block->succ[i]] = 0;
+                stack[top++] = block->succ[i];
+            }
+        }
+    }
+    free(stack);
+    free(inDead);
+}
+
+static int is_label_only(Segment *s, int b) {
+    BasicBlock *block = &s->cfg->blocks[b];
+    return block->last - block->first == 1 && tail_quad(s, b)->op == OP_LABEL;
+}
+
+// Falling off the end of b gets to t, possibly through blocks that hold
+// nothing but labels
+static int falls_to(Segment *s, int b, int t) {
+    return t >= 0 && s->pos[t] > s->pos[b] && s->pos[t] <= s->reach[b];
+}
+
+// Records where the blocks of order go, for falls_to
+static void place_blocks(Segment *s, const int *order, int count) {
+    for (int b = 0; b < s->cfg->blockCount; b++) s->pos[b] = -1;
+    for (int k = 0; k < count; k++) s->pos[order[k]] = k;
+
+    int reach = count;
+    int passes = 0;  // whether the block after this one only passes control on
+    for (int k = count - 1; k >= 0; k--) {
+        int b = order[k];
+        if (!passes) reach = k + 1;
+        s->reach[b] = reach;
+        passes = is_label_only(s, b) && falls_to(s, b, s->fall[b]);
+    }
+}
+
+// Probability that the block ends in a taken jump where it was placed
+static double taken_probability(Segment *s, int b) {
+    Quadruple *q = tail_quad(s, b);
+    int t = s->taken[b];
+    int f = s->fall[b];
+
+    if (q->op == OP_GOTO) return falls_to(s, b, t) ? 0 : 1;
+    if (is_conditional_jump(s->cfg->quads[s->cfg->blocks[b].last - 1])) {
+        if (t >= 0 && t == f) return falls_to(s, b, t) ? 0 : 1;
+        if (f >= 0 && !falls_to(s, b, f)) return falls_to(s, b, t) ? 1 - s->prob[b] : 1;
+        return s->prob[b];
+    }
+    return f >= 0 && !falls_to(s, b, f) ? 1 : 0;
+}
+
+// Expected taken jumps with the blocks laid out in order
+static double layout_cost(Segment *s, const int *order, int count) {
+    place_blocks(s, order, count);
+    double cost = 0;
+    for (int k = 0; k < count; k++) cost += s->freq[order[k]] * taken_probability(s, order[k]);
+    return cost;
+}
+
+typedef struct {
+    int from;
+    int to;
+    double weight;
+} Edge;
+
+static int compare_edges(const void *a, const void *b) {
+    const Edge *x = a;
+    const Edge *y = b;
+    if (x->weight != y->weight) return x->weight < y->weight ? 1 : -1;
+    if (x->from != y->from) return x->from - y->from;
+    return x->to - y->to;
+}
+
+// Greedy chaining in the style of Pettis and Hansen: the heaviest edges
+// become fall-throughs first. Fills order with the blocks that are kept,
+// in their new sequence, and returns their number.
+static int chain_blocks(Segment *s, int *order) {
+    int n = s->cfg->blockCount;
+    int *chainOf = malloc(n * sizeof(int));   // chains are named by their head
+    int *tailOf = malloc(n * sizeof(int));
+    int *next = malloc(n * sizeof(int));
+    Edge *edges = malloc((2 * n + 1) * sizeof(Edge));
+    int edgeCount = 0;
+
+    // The last block stays last when it falls into the code after the segment
+    int pinned = tail_falls_through(s, n - 1) && !s->dead[n - 1] ? n - 1 : -1;
+
+    for (int b = 0; b < n; b++) {
+        chainOf[b] = b;
+        tailOf[b] = b;
+        next[b] = -1;
+        if (b == pinned || s->dead[b]) continue;
+        int succ[2] = { s->taken[b], s->fall[b] == s->taken[b] ? -1 : s->fall[b] };
+        for (int i = 0; i < 2; i++) {
+            if (succ[i] <= 0) continue;  // none, outside, or the entry
+            edges[edgeCount].from = b;
+            edges[edgeCount].to = succ[i];
+            edges[edgeCount].weight = s->freq[b] * edge_probability(s, b, succ[i]);
+            edgeCount++;
+        }
+    }
+    qsort(edges, edgeCount, sizeof(Edge), compare_edges);
+
+    for (int e = 0; e < edgeCount; e++) {
+        int u = edges[e].from;
+        int v = edges[e].to;
+        int cu = chainOf[u];
+        int cv = chainOf[v];
+        if (cu == cv || tailOf[cu] != u || cv != v) continue;
+        // The entry chain goes first and the pinned one last, so they are
+        // kept apart in case other chains have to go in between
+        if (pinned >= 0 && cu == 0 && chainOf[pinned] == cv) continue;
+        next[u] = v;
+        tailOf[cu] = tailOf[cv];
+        for (int x = v; x >= 0; x = next[x]) chainOf[x] = cu;
+    }
+
+    // Entry chain, warm chains, cold chains, then the pinned chain, each
+    // group in source order
+    int count = 0;
+    int pinnedChain = pinned >= 0 ? chainOf[pinned] : -1;
+    for (int pass = 0; pass < 4; pass++) {
+        for (int head = 0; head < n; head++) {
+            if (chainOf[head] != head || s->dead[head]) continue;
+            int group;
+            if (head == 0) group = 0;
+            else if (head == pinnedChain) group = 3;
+            else group = s->freq[head] >= COLD_FRACTION * s->freq[0] ? 1 : 2;
+            if (group != pass) continue;
+            for (int x = head; x >= 0; x = next[x]) order[count++] = x;
+        }
+    }
+
+    free(chainOf);
+    free(tailOf);
+    free(next);
+    free(edges);
+    return count;
+}
+
+static void put(Quadruple *out, int *outCount, OpType op, char *result) {
+    out[*outCount].op = op;
+    out[*outCount].arg1 = NULL;
+    out[*outCount].arg2 = NULL;
+    out[*outCount].result = result;
+    (*outCount)++;
+}
+
+// Quads the blocks take in this order, including the jumps and labels it
+// adds. Marks the blocks that need a new label.
+static int layout_size(Segment *s, const int *order, int count, char *needsLabel) {
+    place_blocks(s, order, count);
+    memset(needsLabel, 0, s->cfg->blockCount);
+    int size = 0;
+    for (int k = 0; k < count; k++) {
+        int b = order[k];
+        BasicBlock *block = &s->cfg->blocks[b];
+        int t = s->taken[b];
+        int f = s->fall[b];
+        int conditional = is_conditional_jump(s->cfg->quads[block->last - 1]);
+        size += block->last - block->first;
+
+        if ((tail_quad(s, b)->op == OP_GOTO || (conditional && t == f)) && t >= 0) {
+            if (falls_to(s, b, t)) size--;
+            else if (!s->label[t]) needsLabel[t] = 1;
+        } else if (f >= 0 && !falls_to(s, b, f)) {
+            if (!s->label[f]) needsLabel[f] = 1;
+            if (!(conditional && falls_to(s, b, t))) size++;
+        }
+    }
+    for (int b = 0; b < s->cfg->blockCount; b++) size += needsLabel[b];
+    return size;
+}
+
+// Lays out quads [first, first + count) into out, leaving out unreachable
+// blocks. The new order is only used if it is estimated to take fewer
+// jumps and fits in room quads, otherwise the blocks keep their source
+// order (which never needs more quads).
+static void layout_segment(int first, int count, Quadruple *out, int *outCount, int room,
+                           double *before, double *after) {
+    int *quads = malloc(count * sizeof(int));
+    for (int i = 0; i < count; i++) quads[i] = first + i;
+
+    Segment s;
+    s.cfg = build_cfg(quads, count);
+    compute_dominators(s.cfg);
+    int n = s.cfg->blockCount;
+    s.label = calloc(n, sizeof(char *));
+    s.taken = malloc(n * sizeof(int));
+    s.fall = malloc(n * sizeof(int));
+    s.prob = malloc(n * sizeof(double));
+    s.freq = calloc(n, sizeof(double));
+    s.dead = malloc(n);
+    s.pos = malloc(n * sizeof(int));
+    s.reach = malloc(n * sizeof(int));
+
+    for (int b = 0; b < n; b++) {
+        Quadruple *head = &quadruples[quads[s.cfg->blocks[b].first]];
+        if (head->op == OP_LABEL) s.label[b] = head->result;
+    }
+    for (int b = 0; b < n; b++) {
+        const char *target = jump_target(quads[s.cfg->blocks[b].last - 1]);
+        s.taken[b] = -1;
+        for (int c = 0; target && c < n; c++) {
+            if (s.label[c] && strcmp(s.label[c], target) == 0) s.taken[b] = c;
+        }
+        s.fall[b] = tail_falls_through(&s, b) && b + 1 < n ? b + 1 : -1;
+    }
+    find_dead_blocks(&s, first, count);
+
+    char **loops = malloc((n + 1) * sizeof(char *));
+    int loopCount = 0;
+    for (int b = 0; b < n; b++) {
+        for (int i = 0; i < s.cfg->blocks[b].succCount; i++) {
+            int header = s.cfg->blocks[b].succ[i];
+            if (dominates(s.cfg, header, b) && loopCount < n) {
+                loops[loopCount++] = natural_loop(s.cfg, b, header);
+            }
+        }
+    }
+
+    double *counts = block_counts(&s);
+    for (int b = 0; b < n; b++) {
+        int t = s.taken[b];
+        int f = s.fall[b];
+        if (!is_conditional_jump(quads[s.cfg->blocks[b].last - 1]) || t == f) {
+            s.prob[b] = tail_quad(&s, b)->op == OP_GOTO || t == f ? 1 : 0;
+        } else if (t < 0 || f < 0) {
+            s.prob[b] = 0.5;
+        } else if (counts[t] >= 0 && counts[f] >= 0 && counts[t] + counts[f] > 0) {
+            s.prob[b] = counts[t] / (counts[t] + counts[f]);
+        } else {
+            s.prob[b] = static_probability(&s, b, loops, loopCount);
+        }
+    }
+    estimate_frequencies(&s, counts[0] >= 0 ? counts[0] : 1);
+
+    int *order = malloc(n * sizeof(int));
+    int *sourceOrder = malloc(n * sizeof(int));
+    int live = chain_blocks(&s, order);
+    for (int b = 0, k = 0; b < n; b++) {
+        if (!s.dead[b]) sourceOrder[k++] = b;
+    }
+
+    double segBefore = layout_cost(&s, sourceOrder, live);
+    double segAfter = layout_cost(&s, order, live);
+    char *needsLabel = calloc(n, 1);
+    if (segAfter >= segBefore || *outCount + layout_size(&s, order, live, needsLabel) > room) {
+        memcpy(order, sourceOrder, live * sizeof(int));
+        segAfter = segBefore;
+        layout_size(&s, order, live, needsLabel);
+    }
+    *before += segBefore;
+    *after += segAfter;
+
+    char **newLabels = calloc(n, sizeof(char *));
+    for (int b = 0; b < n; b++) {
+        if (needsLabel[b]) s.label[b] = newLabels[b] = new_label();
+    }
+
+    for (int k = 0; k < live; k++) {
+        int b = order[k];
+        int t = s.taken[b];
+        int f = s.fall[b];
+        BasicBlock *block = &s.cfg->blocks[b];
+        int conditional = is_conditional_jump(quads[block->last - 1]);
+
+        if (newLabels[b]) put(out, outCount, OP_LABEL, newLabels[b]);
+        for (int pos = block->first; pos < block->last - 1; pos++) {
+            out[(*outCount)++] = quadruples[quads[pos]];
+        }
+
+        Quadruple q = quadruples[quads[block->last - 1]];
+        if ((q.op == OP_GOTO || (conditional && t == f)) && t >= 0) {
+            // Both ways lead to t
+            free(q.arg1);
+            free(q.arg2);
+            free(q.result);
+            if (!falls_to(&s, b, t)) put(out, outCount, OP_GOTO, strdup(s.label[t]));
+            continue;
+        }
+        if (conditional && falls_to(&s, b, t) && f >= 0) {
+            q.op = invert_branch(q.op);
+            free(q.result);
+            q.result = strdup(s.label[f]);
+            out[(*outCount)++] = q;
+            continue;
+        }
+        out[(*outCount)++] = q;
+        if (f >= 0 && !falls_to(&s, b, f)) put(out, outCount, OP_GOTO, strdup(s.label[f]));
+    }
+
+    for (int b = 0; b < n; b++) {
+        BasicBlock *block = &s.cfg->blocks[b];
+        for (int pos = block->first; s.dead[b] && pos < block->last; pos++) {
+            free(quadruples[quads[pos]].arg1);
+            free(quadruples[quads[pos]].arg2);
+            free(quadruples[quads[pos]].result);
+        }
+    }
+
+    for (int l = 0; l < loopCount; l++) free(loops[l]);
+    free(loops);
+    free(counts);
+    free(order);
+    free(sourceOrder);
+    free(needsLabel);
+    free(newLabels);
+    free(s.label);
+    free(s.taken);
+    free(s.fall);
+    free(s.prob);
+    free(s.freq);
+    free(s.dead);
+    free(s.pos);
+    free(s.reach);
+    free_cfg(s.cfg);
+    free(quads);
+}
+
+void layout_blocks(LayoutStats *stats, int report) {
+    int regionCount;
+    Region *regions = collect_regions(&regionCount);
+    int *regionOf = malloc((quad_count + 1) * sizeof(int));
+    for (int i = 0; i < quad_count; i++) regionOf[i] = -1;
+    for (int r = 0; r < regionCount; r++) {
+        for (int i = 0; i < regions[r].count; i++) regionOf[regions[r].quads[i]] = r;
+    }
+
+    double *before = calloc(regionCount + 1, sizeof(double));
+    double *after = calloc(regionCount + 1, sizeof(double));
+    Quadruple *out = malloc(MAX_QUADS * sizeof(Quadruple));
+    int *newIndex = malloc((quad_count + 1) * sizeof(int));
+    int outCount = 0;
+
+    // Function bodies split the top-level code into several segments
+    for (int i = 0; i < quad_count;) {
+        int r = regionOf[i];
+        int end = i + 1;
+        while (r >= 0 && end < quad_count && regionOf[end] == r) end++;
+        for (int q = i; q < end; q++) newIndex[q] = outCount;
+
+        int room = MAX_QUADS - (quad_count - end);
+        if (r >= 0) {
+            layout_segment(i, end - i, out, &outCount, room, &before[r], &after[r]);
+        } else {
+            for (int q = i; q < end; q++) out[outCount++] = quadruples[q];
+        }
+        i = end;
+    }
+    newIndex[quad_count] = outCount;
+
+    memcpy(quadruples, out, outCount * sizeof(Quadruple));
+    quad_count = outCount;
+    remapFunctionQuadRanges(newIndex);
+
+    for (int r = 0; r < regionCount; r++) {
+        if (report && (before[r] - after[r] > 0.05 || after[r] - before[r] > 0.05)) {
+            printf("Block layout of %s: %.1f -> %.1f taken jumps\n", regions[r].name, before[r], after[r]);
+        }
+        stats->takenBefore += before[r];
+        stats->takenAfter += after[r];
+    }
+
+    for (int i = 0; i < coldCount; i++) free(coldLabels[i]);
+    coldCount = 0;
+
+    free(before);
+    free(after);
+    free(out);
+    free(newIndex);
+    free(regionOf);
+    free_regions(regions, regionCount);
+}
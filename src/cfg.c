@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quadruple.h"
+#include "symbol_table.h"
+#include "cfg.h"
+
+const char *jump_target(int quad) {
+    if (quadruples[quad].op == OP_GOTO || is_conditional_jump(quad)) {
+        return quadruples[quad].result;
+    }
+    return NULL;
+}
+
+int is_conditional_jump(int quad) {
+    OpType op = quadruples[quad].op;
+    return op == OP_IFGOTO || op == OP_IFFALSE || is_compare_branch(op);
+}
+
+static int ends_block(int quad) {
+    OpType op = quadruples[quad].op;
+    return jump_target(quad) != NULL || op == OP_RETURN || op == OP_TAILCALL;
+}
+
+static int falls_through(int quad) {
+    OpType op = quadruples[quad].op;
+    return op != OP_GOTO && op != OP_RETURN && op != OP_TAILCALL;
+}
+
+static int contains(SymbolTableEntry *outer, SymbolTableEntry *inner) {
+    return outer != inner && inner->quadStart >= outer->quadStart && inner->quadEnd <= outer->quadEnd;
+}
+
+Region *collect_regions(int *count) {
+    int fnCount;
+    SymbolTableEntry **functions = collectFunctions(&fnCount);
+    Region *regions = malloc((fnCount + 1) * sizeof(Region));
+    char *inFunction = calloc(quad_count, 1);
+
+    *count = 0;
+    for (int i = 0; i < fnCount; i++) {
+        SymbolTableEntry *fn = functions[i];
+        for (int q = fn->quadStart; q < fn->quadEnd; q++) inFunction[q] = 1;
+
+        int nested = 0;
+        for (int j = 0; j < fnCount; j++) {
+            if (contains(fn, functions[j])) nested = 1;
+        }
+        if (nested || fn->quadEnd <= fn->quadStart) continue;
+        if (fn->quadStart < quad_stream_start) continue;  // already written out
+
+        Region *region = &regions[(*count)++];
+        region->name = fn->identifierName;
+        region->count = fn->quadEnd - fn->quadStart;
+        region->quads = malloc(region->count * sizeof(int));
+        for (int q = 0; q < region->count; q++) region->quads[q] = fn->quadStart + q;
+    }
+
+    Region *top = &regions[(*count)++];
+    top->name = "main";
+    top->quads = malloc((quad_count + 1) * sizeof(int));
+    top->count = 0;
+    for (int q = quad_stream_start; q < quad_count; q++) {
+        if (!inFunction[q]) top->quads[top->count++] = q;
+    }
+
+    free(inFunction);
+    free(functions);
+    return regions;
+}
+
+void free_regions(Region *regions, int count) {
+    for (int i = 0; i < count; i++) {
+        free(regions[i].quads);
+    }
+    free(regions);
+}
+
+static int find_label_block(Cfg *cfg, const int *blockOf, const char *label) {
+    for (int pos = 0; pos < cfg->quadCount; pos++) {
+        Quadruple *q = &quadruples[cfg->quads[pos]];
+        if (q->op == OP_LABEL && q->result && strcmp(q->result, label) == 0) {
+            return blockOf[pos];
+        }
+    }
+    return -1;  // outside the region
+}
+
+static void add_edge(Cfg *cfg, int from, int to) {
+    BasicBlock *b = &cfg->blocks[from];
+    if (to < 0 || (b->succCount == 1 && b->succ[0] == to)) return;
+    b->succ[b->succCount++] = to;
+    cfg->blocks[to].predCount++;
+}
+
+static void number_blocks(Cfg *cfg) {
+    // Iterative DFS, postorder is filled from the back to get reverse postorder
+    int *stack = malloc(cfg->blockCount * sizeof(int));
+    int *next = calloc(cfg->blockCount, sizeof(int));
+    char *visited = calloc(cfg->blockCount, 1);
+    int *post = malloc(cfg->blockCount * sizeof(int));
+    int postCount = 0;
+    int top = 0;
+
+    stack[top++] = 0;
+    visited[0] = 1;
+    while (top > 0) {
+        int b = stack[top - 1];
+        if (next[b] < cfg->blocks[b].succCount) {
+            int s = cfg->blocks[b].succ[next[b]++];
+            if (!visited[s]) {
+                visited[s] = 1;
+                stack[top++] = s;
+            }
+        } else {
+            post[postCount++] = b;
+            top--;
+        }
+    }
+
+    cfg->order = malloc((postCount + 1) * sizeof(int));
+    cfg->orderCount = postCount;
+    for (int i = 0; i < postCount; i++) {
+        cfg->order[i] = post[postCount - 1 - i];
+        cfg->blocks[cfg->order[i]].rpo = i;
+    }
+
+    free(stack);
+    free(next);
+    free(visited);
+    free(post);
+}
+
+Cfg *build_cfg(const int *quads, int count) {
+    Cfg *cfg = calloc(1, sizeof(Cfg));
+    cfg->quads = malloc((count + 1) * sizeof(int));
+    memcpy(cfg->quads, quads, count * sizeof(int));
+    cfg->quadCount = count;
+
+    // A block starts at the region entry, at every label and after every jump
+    int *blockOf = malloc((count + 1) * sizeof(int));
+    cfg->blockCount = 0;
+    for (int pos = 0; pos < count; pos++) {
+        int leader = pos == 0 || quadruples[quads[pos]].op == OP_LABEL || ends_block(quads[pos - 1]);
+        if (leader) cfg->blockCount++;
+        blockOf[pos] = cfg->blockCount - 1;
+    }
+
+    cfg->blocks = calloc(cfg->blockCount + 1, sizeof(BasicBlock));
+    for (int pos = 0; pos < count; pos++) {
+        BasicBlock *b = &cfg->blocks[blockOf[pos]];
+        if (pos == 0 || blockOf[pos - 1] != blockOf[pos]) b->first = pos;
+        b->last = pos + 1;
+    }
+
+    for (int i = 0; i < cfg->blockCount; i++) {
+        BasicBlock *b = &cfg->blocks[i];
+        int tail = quads[b->last - 1];
+        b->idom = -1;
+        b->rpo = -1;
+        const char *target = jump_target(tail);
+        if (target) {
+            add_edge(cfg, i, find_label_block(cfg, blockOf, target));
+        }
+        if (falls_through(tail) && i + 1 < cfg->blockCount) {
+            add_edge(cfg, i, i + 1);
+        }
+    }
+
+    for (int i = 0; i < cfg->blockCount; i++) {
+        cfg->blocks[i].preds = malloc((cfg->blocks[i].predCount + 1) * sizeof(int));
+        cfg->blocks[i].predCount = 0;
+    }
+    for (int i = 0; i < cfg->blockCount; i++) {
+        for (int s = 0; s < cfg->blocks[i].succCount; s++) {
+            BasicBlock *succ = &cfg->blocks[cfg->blocks[i].succ[s]];
+            succ->preds[succ->predCount++] = i;
+        }
+    }
+
+    if (cfg->blockCount > 0) number_blocks(cfg);
+    free(blockOf);
+    return cfg;
+}
+
+static int intersect(Cfg *cfg, int a, int b) {
+    while (a != b) {
+        while (cfg->blocks[a].rpo > cfg->blocks[b].rpo) a = cfg->blocks[a].idom;
+        while (cfg->blocks[b].rpo > cfg->blocks[a].rpo) b = cfg->blocks[b].idom;
+    }
+    return a;
+}
+
+// Cooper, Harvey and Kennedy's iterative algorithm over reverse postorder
+void compute_dominators(Cfg *cfg) {
+    if (cfg->orderCount == 0) return;
+    int entry = cfg->order[0];
+    cfg->blocks[entry].idom = entry;
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < cfg->orderCount; i++) {
+            BasicBlock *b = &cfg->blocks[cfg->order[i]];
+            int idom = -1;
+            for (int p = 0; p < b->predCount; p++) {
+                int pred = b->preds[p];
+                if (cfg->blocks[pred].idom < 0) continue;  // not processed or unreachable
+                idom = idom < 0 ? pred : intersect(cfg, pred, idom);
+            }
+            if (idom != b->idom) {
+                b->idom = idom;
+                changed = 1;
+            }
+        }
+    }
+    cfg->blocks[entry].idom = -1;
+}
+
+static void add_frontier(BasicBlock *b, int block, int capacity) {
+    for (int i = 0; i < b->frontierCount; i++) {
+        if (b->frontier[i] == block) return;
+    }
+    if (!b->frontier) b->frontier = malloc(capacity * sizeof(int));
+    b->frontier[b->frontierCount++] = block;
+}
+
+void compute_dominance_frontiers(Cfg *cfg) {
+    for (int i = 0; i < cfg->orderCount; i++) {
+        int block = cfg->order[i];
+        BasicBlock *b = &cfg->blocks[block];
+        if (b->predCount < 2) continue;
+        for (int p = 0; p < b->predCount; p++) {
+            int runner = b->preds[p];
+            if (cfg->blocks[runner].rpo < 0) continue;
+            while (runner >= 0 && runner != b->idom) {
+                add_frontier(&cfg->blocks[runner], block, cfg->blockCount);
+                runner = cfg->blocks[runner].idom;
+            }
+        }
+    }
+}
+
+void free_cfg(Cfg *cfg) {
+    for (int i = 0; i < cfg->blockCount; i++) {
+        free(cfg->blocks[i].preds);
+        free(cfg->blocks[i].frontier);
+    }
+    free(cfg->blocks);
+    free(cfg->order);
+    free(cfg->quads);
+    free(cfg);
+}
@@ -1,31 +1,197 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include "error_handler.h"
 
-#define MAX_ERRORS 100
+// Position of the last token, maintained by the lexer
+extern int token_line;
+extern int token_column;
+
+// Diagnostics kept for print_all_errors, the others are only in the sink
+#define MAX_PRINTED_DIAGNOSTICS 50
+
+// Repeats are dropped when they match one of this many recent diagnostics
+#define DEDUP_WINDOW 32
 
 typedef struct {
     ErrorType type;
-    char message[256];
+    char *message;
     int line;
 } Error;
 
-static Error errors[MAX_ERRORS];
+typedef struct {
+    uint64_t key;        // hash of the fields below, 0 for an empty slot
+    ErrorType type;
+    int line;
+    char *code;
+    char *message;
+} RecentDiagnostic;
+
+static Error printed[MAX_PRINTED_DIAGNOSTICS];
+static int printed_count = 0;
+static int diagnostic_count = 0;
 static int error_count = 0;
+static int max_errors = DEFAULT_MAX_ERRORS;
 
-void report_error(ErrorType type, const char *message, int line) {
-    if (error_count >= MAX_ERRORS) return;
-    errors[error_count].type = type;
-    strncpy(errors[error_count].message, message, 255);
-    errors[error_count].line = line;
+static RecentDiagnostic recent[DEDUP_WINDOW];
+static int recent_next = 0;
+
+static FILE *sink = NULL;
+static const char *sink_name = NULL;
+
+void open_diagnostics(const char *filename) {
+    sink_name = filename;
+    sink = fopen(filename, "w");
+    if (!sink) {
+        printf("Error opening file %s\n", filename);
+    }
+}
+
+void close_diagnostics() {
+    if (sink) {
+        fclose(sink);
+        sink = NULL;
+    }
+}
+
+void set_max_errors(int limit) {
+    max_errors = limit;
+}
+
+static uint64_t hash_string(uint64_t h, const char *s) {
+    while (s && *s) {
+        h = (h ^ (unsigned char)*s++) * 1099511628211ULL;
+    }
+    return (h ^ 0xff) * 1099511628211ULL;
+}
+
+static int same_string(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+// Returns 1 if the diagnostic repeats a recent one, otherwise remembers it
+// in place of the oldest
+static int check_recent(uint64_t key, ErrorType type, int line, const char *code, const char *message) {
+    if (key == 0) key = 1;  // 0 marks an empty slot
+
+    for (int i = 0; i < DEDUP_WINDOW; i++) {
+        RecentDiagnostic *r = &recent[i];
+        if (r->key == key && r->type == type && r->line == line &&
+            same_string(r->code, code) && strcmp(r->message, message) == 0) {
+            return 1;
+        }
+    }
+
+    RecentDiagnostic *r = &recent[recent_next];
+    recent_next = (recent_next + 1) % DEDUP_WINDOW;
+    free(r->code);
+    free(r->message);
+    r->key = key;
+    r->type = type;
+    r->line = line;
+    r->code = code ? strdup(code) : NULL;
+    r->message = strdup(message);
+    return 0;
+}
+
+static const char *kind_string(ErrorType type) {
+    switch (type) {
+        case SYNTAX_ERROR: return "syntax";
+        case SEMANTIC_ERROR: return "semantic";
+        case SEMANTIC_WARNING: return "warning";
+        default: return "unknown";
+    }
+}
+
+static void write_json_string(FILE *fp, const char *s) {
+    if (!s) {
+        fputs("null", fp);
+        return;
+    }
+    fputc('"', fp);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+            case '"': fputs("\\\"", fp); break;
+            case '\\': fputs("\\\\", fp); break;
+            case '\n': fputs("\\n", fp); break;
+            case '\r': fputs("\\r", fp); break;
+            case '\t': fputs("\\t", fp); break;
+            default:
+                if (c < 0x20) fprintf(fp, "\\u%04x", c);
+                else fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+static void write_json_line(const char *kind, const char *code, int line, int column, const char *message, const char *symbol) {
+    if (!sink) return;
+    fputs("{\"kind\":", sink);
+    write_json_string(sink, kind);
+    fputs(",\"code\":", sink);
+    write_json_string(sink, code);
+    fprintf(sink, ",\"line\":%d,\"column\":%d,\"message\":", line, column);
+    write_json_string(sink, message);
+    fputs(",\"symbol\":", sink);
+    write_json_string(sink, symbol);
+    fputs("}\n", sink);
+    fflush(sink);
+}
+
+static void store(ErrorType type, const char *message, int line) {
+    diagnostic_count++;
+    if (printed_count == MAX_PRINTED_DIAGNOSTICS) return;
+    printed[printed_count].type = type;
+    printed[printed_count].message = strdup(message);
+    printed[printed_count].line = line;
+    printed_count++;
+}
+
+void report_diagnostic(ErrorType type, const char *code, int line, const char *symbol, const char *format, ...) {
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    uint64_t key = hash_string(14695981039346656037ULL + type * 31 + line, code);
+    key = hash_string(key, message);
+    if (check_recent(key, type, line, code, message)) return;
+
+    int column = (line == token_line) ? token_column : 0;
+    write_json_line(kind_string(type), code, line, column, message, symbol);
+    store(type, message, line);
+
+    if (type == SEMANTIC_WARNING) return;
     error_count++;
+
+    if (max_errors > 0 && error_count >= max_errors) {
+        char fatal[128];
+        snprintf(fatal, sizeof(fatal), "Too many errors (%d), compilation aborted.", error_count);
+        write_json_line("fatal", "Too Many Errors", line, column, fatal, NULL);
+        print_all_errors();
+        printf("%s\n", fatal);
+        close_diagnostics();
+        exit(EXIT_FAILURE);
+    }
+}
+
+void report_error(ErrorType type, const char *message, int line) {
+    report_diagnostic(type, message, line, NULL, "%s", message);
 }
 
 void print_all_errors() {
-    for (int i = 0; i < error_count; i++) {
-        const char *type_str = (errors[i].type == SYNTAX_ERROR) ? "Syntax" : "Semantic";
-        printf("[%s Error] Line %d: %s\n", type_str, errors[i].line, errors[i].message);
+    for (int i = 0; i < printed_count; i++) {
+        const char *type_str = (printed[i].type == SYNTAX_ERROR) ? "Syntax Error"
+                             : (printed[i].type == SEMANTIC_ERROR) ? "Semantic Error" : "Semantic Warning";
+        printf("[%s] Line %d: %s\n", type_str, printed[i].line, printed[i].message);
+    }
+    if (diagnostic_count > printed_count) {
+        printf("... %d more diagnostic(s) in %s\n", diagnostic_count - printed_count,
+               sink_name ? sink_name : "the diagnostics file");
     }
 }
 
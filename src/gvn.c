@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "quadruple.h"
+#include "symbol_table.h"
+#include "cfg.h"
+#include "gvn.h"
+
+// Value numbering runs on an implicit SSA form. Each variable is given a
+// value number at every definition and at the phi nodes placed on its
+// dominance frontier, and the dominator tree is walked with scoped tables,
+// so a value number is only reused where its defining temp dominates.
+//
+// Only temps defined exactly once are ever removed, and uses are redirected
+// to another single-definition temp. Neither is ever reassigned, so every
+// phi is equivalent to a copy between identical names and leaving SSA needs
+// no copies (the program stays in conventional SSA form).
+
+typedef struct {
+    const char **names;     // operand strings of the region, by id
+    int count;
+    int *slots;             // open-addressing table of ids
+    int capacity;
+} NameTable;
+
+typedef struct {
+    int op, a, b;
+    int vn;
+} ExprKey;
+
+// Undo log entry: table 0 is varVN, table 1 is leader
+typedef struct {
+    int table;
+    int index;
+    int old;
+} Undo;
+
+typedef struct {
+    Cfg *cfg;
+    NameTable names;
+    int *defCount;          // definitions of each name in the region
+    char *isLiteral;
+    int *varVN;             // current value number of each name, -1 if unset
+    int *litVN;
+    int *leader;            // single-definition temp holding each value number
+    int leaderCapacity;
+    int nextVN;
+    ExprKey *exprs;
+    int exprCapacity;
+    int exprCount;
+    Undo *log;
+    int logCount;
+    int logCapacity;
+    int **phis;             // names needing a phi at the start of each block
+    int *phiCount;
+    int *clobbered;         // names a call may change
+    int clobberedCount;
+    int **children;         // dominator tree
+    int *childCount;
+    int *subst;             // replacement id for removed temps, -1 otherwise
+    char *removed;          // per region position
+    int eliminated;
+} Gvn;
+
+static unsigned int hash_text(const char *s) {
+    unsigned int h = 2166136261u;
+    while (*s) {
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    }
+    return h;
+}
+
+static int name_id(NameTable *t, const char *name) {
+    unsigned int slot = hash_text(name) & (t->capacity - 1);
+    while (t->slots[slot] >= 0) {
+        if (strcmp(t->names[t->slots[slot]], name) == 0) return t->slots[slot];
+        slot = (slot + 1) & (t->capacity - 1);
+    }
+    t->names[t->count] = name;
+    t->slots[slot] = t->count;
+    return t->count++;
+}
+
+static int is_literal(const char *s) {
+    return isdigit((unsigned char)s[0]) || s[0] == '-' || s[0] == '.' || s[0] == '\'' ||
+           s[0] == '"' || strcmp(s, "true") == 0 || strcmp(s, "false") == 0;
+}
+
+static int is_value_op(OpType op) {
+    switch (op) {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD: case OP_EXP:
+        case OP_LT: case OP_GT: case OP_LTE: case OP_GTE: case OP_EQ: case OP_NEQ:
+        case OP_AND: case OP_OR: case OP_NOT: case OP_UMINUS:
+        case OP_ITOF: case OP_FTOI: case OP_CTOI: case OP_ITOB:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int is_commutative(OpType op) {
+    return op == OP_ADD || op == OP_MUL || op == OP_EQ || op == OP_NEQ || op == OP_AND || op == OP_OR;
+}
+
+static int defines_result(OpType op) {
+    return is_value_op(op) || op == OP_ASSIGN || op == OP_CALL || op == OP_INC || op == OP_DEC;
+}
+
+// Operands that name values, as opposed to labels and function names
+static int has_value_operands(OpType op) {
+    return op != OP_LABEL && op != OP_GOTO && op != OP_CALL && op != OP_TAILCALL;
+}
+
+static int fresh_vn(Gvn *g) {
+    if (g->nextVN == g->leaderCapacity) {
+        g->leaderCapacity *= 2;
+        g->leader = realloc(g->leader, g->leaderCapacity * sizeof(int));
+    }
+    g->leader[g->nextVN] = -1;
+    return g->nextVN++;
+}
+
+static void set_logged(Gvn *g, int table, int index, int value) {
+    int *slot = table == 0 ? &g->varVN[index] : &g->leader[index];
+    if (g->logCount == g->logCapacity) {
+        g->logCapacity = g->logCapacity ? g->logCapacity * 2 : 64;
+        g->log = realloc(g->log, g->logCapacity * sizeof(Undo));
+    }
+    g->log[g->logCount++] = (Undo){ table, index, *slot };
+    *slot = value;
+}
+
+static void undo_to(Gvn *g, int mark) {
+    while (g->logCount > mark) {
+        Undo *u = &g->log[--g->logCount];
+        if (u->table == 0) g->varVN[u->index] = u->old;
+        else g->leader[u->index] = u->old;
+    }
+}
+
+static int single_def_temp(Gvn *g, int id) {
+    return g->defCount[id] == 1 && is_temp(g->names.names[id]);
+}
+
+static int operand_vn(Gvn *g, const char *operand) {
+    if (!operand) return -1;
+    int id = name_id(&g->names, operand);
+    if (g->isLiteral[id]) return g->litVN[id];
+    if (g->varVN[id] < 0) {
+        // No definition dominates this use, so it reads the value on entry
+        g->varVN[id] = fresh_vn(g);
+    }
+    return g->varVN[id];
+}
+
+static int expr_vn(Gvn *g, int op, int a, int b) {
+    unsigned int h = (unsigned int)op * 31u + (unsigned int)a * 1000003u + (unsigned int)b * 7919u;
+    int slot = h & (g->exprCapacity - 1);
+    while (g->exprs[slot].vn >= 0) {
+        ExprKey *e = &g->exprs[slot];
+        if (e->op == op && e->a == a && e->b == b) return e->vn;
+        slot = (slot + 1) & (g->exprCapacity - 1);
+    }
+    g->exprs[slot] = (ExprKey){ op, a, b, fresh_vn(g) };
+    g->exprCount++;
+    return g->exprs[slot].vn;
+}
+
+static void define(Gvn *g, int pos, int id, int vn) {
+    if (single_def_temp(g, id)) {
+        if (g->leader[vn] >= 0) {
+            g->subst[id] = g->leader[vn];
+            g->removed[pos] = 1;
+            g->eliminated++;
+        } else {
+            set_logged(g, 1, vn, id);
+        }
+    }
+    set_logged(g, 0, id, vn);
+}
+
+static void number_quad(Gvn *g, int pos) {
+    Quadruple *q = &quadruples[g->cfg->quads[pos]];
+
+    if (is_value_op(q->op)) {
+        int a = operand_vn(g, q->arg1);
+        int b = operand_vn(g, q->arg2);
+        if (is_commutative(q->op) && a > b) {
+            int t = a; a = b; b = t;
+        }
+        if (q->result) define(g, pos, name_id(&g->names, q->result), expr_vn(g, q->op, a, b));
+    } else if (q->op == OP_ASSIGN) {
+        if (q->result && q->arg1) define(g, pos, name_id(&g->names, q->result), operand_vn(g, q->arg1));
+    } else if (q->op == OP_CALL) {
+        for (int i = 0; i < g->clobberedCount; i++) {
+            set_logged(g, 0, g->clobbered[i], fresh_vn(g));
+        }
+        if (q->result) define(g, pos, name_id(&g->names, q->result), fresh_vn(g));
+    } else if ((q->op == OP_INC || q->op == OP_DEC) && q->result) {
+        define(g, pos, name_id(&g->names, q->result), fresh_vn(g));
+    }
+}
+
+static void walk(Gvn *g, int block) {
+    int mark = g->logCount;
+    BasicBlock *b = &g->cfg->blocks[block];
+
+    for (int i = 0; i < g->phiCount[block]; i++) {
+        set_logged(g, 0, g->phis[block][i], fresh_vn(g));
+    }
+    for (int pos = b->first; pos < b->last; pos++) {
+        number_quad(g, pos);
+    }
+    for (int i = 0; i < g->childCount[block]; i++) {
+        walk(g, g->children[block][i]);
+    }
+
+    undo_to(g, mark);
+}
+
+static void add_to_list(int **list, int *count, int value, int capacity) {
+    if (!list[0]) *list = malloc(capacity * sizeof(int));
+    (*list)[(*count)++] = value;
+}
+
+// Standard phi placement: iterate each variable's definition blocks over
+// their dominance frontiers
+static void place_phis(Gvn *g, int **defBlocks, int *defBlockCount, const int *callBlocks, int callBlockCount) {
+    Cfg *cfg = g->cfg;
+    int *hasPhi = malloc(cfg->blockCount * sizeof(int));
+    int *queued = malloc(cfg->blockCount * sizeof(int));
+    int *work = malloc((cfg->blockCount * 2 + 1) * sizeof(int));
+    char *isClobbered = calloc(g->names.count, 1);
+    for (int i = 0; i < g->clobberedCount; i++) isClobbered[g->clobbered[i]] = 1;
+    for (int i = 0; i < cfg->blockCount; i++) hasPhi[i] = queued[i] = -1;
+
+    for (int id = 0; id < g->names.count; id++) {
+        if (g->isLiteral[id] || single_def_temp(g, id)) continue;
+        if (defBlockCount[id] == 0 && !isClobbered[id]) continue;
+
+        int top = 0;
+        for (int i = 0; i < defBlockCount[id]; i++) {
+            if (queued[defBlocks[id][i]] != id) {
+                queued[defBlocks[id][i]] = id;
+                work[top++] = defBlocks[id][i];
+            }
+        }
+        if (isClobbered[id]) {
+            for (int i = 0; i < callBlockCount; i++) {
+                if (queued[callBlocks[i]] != id) {
+                    queued[callBlocks[i]] = id;
+                    work[top++] = callBlocks[i];
+                }
+            }
+        }
+
+        while (top > 0) {
+            BasicBlock *b = &cfg->blocks[work[--top]];
+            for (int f = 0; f < b->frontierCount; f++) {
+                int join = b->frontier[f];
+                if (hasPhi[join] == id) continue;
+                hasPhi[join] = id;
+                add_to_list(&g->phis[join], &g->phiCount[join], id, g->names.count);
+                if (queued[join] != id) {
+                    queued[join] = id;
+                    work[top++] = join;
+                }
+            }
+        }
+    }
+
+    free(hasPhi);
+    free(queued);
+    free(work);
+    free(isClobbered);
+}
+
+static int pow2_at_least(int n) {
+    int p = 16;
+    while (p < n) p *= 2;
+    return p;
+}
+
+// Numbers one region and records removed positions in removedQuad
+static int number_region(Region *region, char *removedQuad) {
+    if (region->count == 0) return 0;
+
+    Gvn g;
+    memset(&g, 0, sizeof(g));
+    g.cfg = build_cfg(region->quads, region->count);
+    Cfg *cfg = g.cfg;
+    compute_dominators(cfg);
+    compute_dominance_frontiers(cfg);
+
+    int maxNames = 3 * region->count;
+    g.names.capacity = pow2_at_least(2 * maxNames);
+    g.names.names = malloc(maxNames * sizeof(char *));
+    g.names.slots = malloc(g.names.capacity * sizeof(int));
+    memset(g.names.slots, 0xFF, g.names.capacity * sizeof(int));
+
+    int *blockOf = malloc(region->count * sizeof(int));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        for (int pos = cfg->blocks[b].first; pos < cfg->blocks[b].last; pos++) blockOf[pos] = b;
+    }
+
+    // Collect names first so the per-name arrays can be sized
+    for (int pos = 0; pos < region->count; pos++) {
+        Quadruple *q = &quadruples[region->quads[pos]];
+        if (has_value_operands(q->op)) {
+            if (q->arg1) name_id(&g.names, q->arg1);
+            if (q->arg2) name_id(&g.names, q->arg2);
+        }
+        if (q->result && defines_result(q->op)) name_id(&g.names, q->result);
+    }
+
+    int n = g.names.count;
+    g.defCount = calloc(n + 1, sizeof(int));
+    g.isLiteral = calloc(n + 1, 1);
+    g.varVN = malloc((n + 1) * sizeof(int));
+    g.litVN = malloc((n + 1) * sizeof(int));
+    g.subst = malloc((n + 1) * sizeof(int));
+    g.clobbered = malloc((n + 1) * sizeof(int));
+    g.leaderCapacity = 64;
+    g.leader = malloc(g.leaderCapacity * sizeof(int));
+    g.exprCapacity = pow2_at_least(2 * region->count);
+    g.exprs = malloc(g.exprCapacity * sizeof(ExprKey));
+    for (int i = 0; i < g.exprCapacity; i++) g.exprs[i].vn = -1;
+    g.phis = calloc(cfg->blockCount + 1, sizeof(int *));
+    g.phiCount = calloc(cfg->blockCount + 1, sizeof(int));
+    g.children = calloc(cfg->blockCount + 1, sizeof(int *));
+    g.childCount = calloc(cfg->blockCount + 1, sizeof(int));
+    g.removed = calloc(region->count, 1);
+
+    int **defBlocks = calloc(n + 1, sizeof(int *));
+    int *defBlockCount = calloc(n + 1, sizeof(int));
+    int *callBlocks = malloc((cfg->blockCount + 1) * sizeof(int));
+    int callBlockCount = 0;
+
+    for (int id = 0; id < n; id++) {
+        g.isLiteral[id] = is_literal(g.names.names[id]);
+        g.varVN[id] = -1;
+        g.subst[id] = -1;
+        g.litVN[id] = g.isLiteral[id] ? fresh_vn(&g) : -1;
+        if (!g.isLiteral[id] && !is_temp(g.names.names[id])) g.clobbered[g.clobberedCount++] = id;
+    }
+
+    for (int pos = 0; pos < region->count; pos++) {
+        Quadruple *q = &quadruples[region->quads[pos]];
+        int block = blockOf[pos];
+        if (q->op == OP_CALL && (callBlockCount == 0 || callBlocks[callBlockCount - 1] != block)) {
+            callBlocks[callBlockCount++] = block;
+        }
+        if (!q->result || !defines_result(q->op)) continue;
+        int id = name_id(&g.names, q->result);
+        g.defCount[id]++;
+        if (defBlockCount[id] == 0 || defBlocks[id][defBlockCount[id] - 1] != block) {
+            add_to_list(&defBlocks[id], &defBlockCount[id], block, cfg->blockCount);
+        }
+    }
+    if (callBlockCount == 0) g.clobberedCount = 0;
+
+    place_phis(&g, defBlocks, defBlockCount, callBlocks, callBlockCount);
+
+    for (int i = 0; i < cfg->orderCount; i++) {
+        int block = cfg->order[i];
+        int idom = cfg->blocks[block].idom;
+        if (idom >= 0) add_to_list(&g.children[idom], &g.childCount[idom], block, cfg->blockCount);
+    }
+    if (cfg->orderCount > 0) walk(&g, cfg->order[0]);
+
+    // Redirect uses of removed temps to the temp that already holds the value
+    for (int pos = 0; pos < region->count; pos++) {
+        int quad = region->quads[pos];
+        Quadruple *q = &quadruples[quad];
+        if (g.removed[pos]) {
+            removedQuad[quad] = 1;
+            continue;
+        }
+        if (!has_value_operands(q->op)) continue;
+        char **operands[2] = { &q->arg1, &q->arg2 };
+        for (int k = 0; k < 2; k++) {
+            if (!*operands[k]) continue;
+            int id = name_id(&g.names, *operands[k]);
+            if (g.subst[id] >= 0) {
+                char *replacement = strdup(g.names.names[g.subst[id]]);
+                free(*operands[k]);
+                *operands[k] = replacement;
+            }
+        }
+    }
+
+    int eliminated = g.eliminated;
+    for (int i = 0; i < cfg->blockCount; i++) {
+        free(g.phis[i]);
+        free(g.children[i]);
+    }
+    for (int id = 0; id < n; id++) free(defBlocks[id]);
+    free(defBlocks); free(defBlockCount); free(callBlocks); free(blockOf);
+    free(g.phis); free(g.phiCount); free(g.children); free(g.childCount);
+    free(g.names.names); free(g.names.slots);
+    free(g.defCount); free(g.isLiteral); free(g.varVN); free(g.litVN);
+    free(g.subst); free(g.clobbered); free(g.leader); free(g.exprs);
+    free(g.log); free(g.removed);
+    free_cfg(cfg);
+    return eliminated;
+}
+
+int global_value_numbering(int report) {
+    if (quad_count == 0) return 0;
+
+    int regionCount;
+    Region *regions = collect_regions(&regionCount);
+    char *removedQuad = calloc(quad_count, 1);
+    int total = 0;
+
+    for (int r = 0; r < regionCount; r++) {
+        int eliminated = number_region(&regions[r], removedQuad);
+        if (report && eliminated > 0) {
+            printf("Value numbering removed %d quad(s) from %s\n", eliminated, regions[r].name);
+        }
+        total += eliminated;
+    }
+
+    if (total > 0) {
+        int *newIndex = malloc((quad_count + 1) * sizeof(int));
+        int out = 0;
+        for (int i = 0; i < quad_count; i++) {
+            newIndex[i] = out;
+            if (removedQuad[i]) {
+                free(quadruples[i].arg1);
+                free(quadruples[i].arg2);
+                free(quadruples[i].result);
+            } else {
+                quadruples[out++] = quadruples[i];
+            }
+        }
+        newIndex[quad_count] = out;
+        quad_count = out;
+        remapFunctionQuadRanges(newIndex);
+        free(newIndex);
+    }
+
+    free(removedQuad);
+    free_regions(regions, regionCount);
+    return total;
+}
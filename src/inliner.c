@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quadruple.h"
+#include "symbol_table.h"
+#include "inliner.h"
+
+// Temps and labels of one inlined copy are renamed to fresh ones
+typedef struct {
+    char *from[3 * INLINE_MAX_BODY_QUADS];
+    char *to[3 * INLINE_MAX_BODY_QUADS];
+    int count;
+} RenameMap;
+
+static int count_params(const Parameter *param) {
+    int count = 0;
+    while (param) {
+        count++;
+        param = param->next;
+    }
+    return count;
+}
+
+static const Parameter *find_param(const Parameter *param, const char *name) {
+    while (param) {
+        if (strcmp(param->name, name) == 0) return param;
+        param = param->next;
+    }
+    return NULL;
+}
+
+static int is_jump(OpType op) {
+    return op == OP_GOTO || op == OP_IFGOTO || op == OP_IFFALSE || is_compare_branch(op);
+}
+
+static int defines_label(SymbolTableEntry *fn, const char *label) {
+    for (int i = fn->quadStart + 1; i < fn->quadEnd; i++) {
+        if (quadruples[i].op == OP_LABEL && quadruples[i].result &&
+            strcmp(quadruples[i].result, label) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// A function can be inlined if its body is small, never calls itself and
+// keeps all of its control flow inside the body
+static int is_inlinable(SymbolTableEntry *fn) {
+    if (fn->quadStart < 0 || fn->quadEnd <= fn->quadStart) return 0;
+    if (fn->quadEnd - fn->quadStart - 1 > INLINE_MAX_BODY_QUADS) return 0;
+
+    for (int i = fn->quadStart + 1; i < fn->quadEnd; i++) {
+        Quadruple *q = &quadruples[i];
+        if (q->op == OP_CALL && strcmp(q->arg1, fn->identifierName) == 0) return 0;
+        if (q->op == OP_TAILCALL) return 0;  // would return from the caller
+        if (q->op == OP_LABEL && !is_label(q->result)) return 0;  // nested function
+        if (is_jump(q->op) && (!is_label(q->result) || !defines_label(fn, q->result))) return 0;
+    }
+    return 1;
+}
+
+// One past the last reachable body quad: the implicit RETURN appended by
+// function_decl is dropped when an explicit RETURN already precedes it
+static int body_end(SymbolTableEntry *fn) {
+    int end = fn->quadEnd;
+    if (end - 2 > fn->quadStart && quadruples[end - 1].op == OP_RETURN &&
+        !quadruples[end - 1].arg1 && quadruples[end - 2].op == OP_RETURN) {
+        end--;
+    }
+    return end;
+}
+
+// Number of quads emitted in place of one call (mirrors emit_body)
+static int inline_cost(SymbolTableEntry *fn) {
+    int end = body_end(fn);
+    int cost = 0;
+    int needs_exit = 0;
+    for (int i = fn->quadStart + 1; i < end; i++) {
+        if (quadruples[i].op == OP_RETURN) {
+            if (quadruples[i].arg1) cost++;
+            if (i != end - 1) {
+                cost++;
+                needs_exit = 1;
+            }
+        } else {
+            cost++;
+        }
+    }
+    return cost + needs_exit;
+}
+
+static char *param_copy_name(const char *param, int instance) {
+    char *name = malloc(strlen(param) + 16);
+    sprintf(name, "%s.%d", param, instance);
+    return name;
+}
+
+static char *rename_operand(const char *s, SymbolTableEntry *fn, int instance, RenameMap *map) {
+    if (!s) return NULL;
+
+    if (is_temp(s) || is_label(s)) {
+        for (int i = 0; i < map->count; i++) {
+            if (strcmp(map->from[i], s) == 0) return strdup(map->to[i]);
+        }
+        map->from[map->count] = (char *)s;
+        map->to[map->count] = is_temp(s) ? new_temp() : new_label();
+        return strdup(map->to[map->count++]);
+    }
+
+    if (find_param(fn->params, s)) return param_copy_name(s, instance);
+    return strdup(s);
+}
+
+static void emit(Quadruple *out, int *out_count, OpType op, char *arg1, char *arg2, char *result) {
+    out[*out_count].op = op;
+    out[*out_count].arg1 = arg1;
+    out[*out_count].arg2 = arg2;
+    out[*out_count].result = result;
+    (*out_count)++;
+}
+
+// Copies the body of fn in place of a call whose value lands in result.
+// Every RETURN becomes an assignment to result followed by a jump to the
+// end of the copy, except for the last one which simply falls through.
+static void emit_body(SymbolTableEntry *fn, int instance, const char *result, Quadruple *out, int *out_count) {
+    RenameMap map = { .count = 0 };
+    char *exit_label = NULL;
+    int end = body_end(fn);
+
+    for (int i = fn->quadStart + 1; i < end; i++) {
+        Quadruple *q = &quadruples[i];
+        if (q->op == OP_RETURN) {
+            if (q->arg1) {
+                emit(out, out_count, OP_ASSIGN, rename_operand(q->arg1, fn, instance, &map), NULL,
+                     result ? strdup(result) : NULL);
+            }
+            if (i != end - 1) {
+                if (!exit_label) exit_label = new_label();
+                emit(out, out_count, OP_GOTO, NULL, NULL, strdup(exit_label));
+            }
+        } else if (q->op == OP_CALL) {
+            emit(out, out_count, q->op, strdup(q->arg1), NULL, rename_operand(q->result, fn, instance, &map));
+        } else {
+            emit(out, out_count, q->op,
+                 rename_operand(q->arg1, fn, instance, &map),
+                 rename_operand(q->arg2, fn, instance, &map),
+                 rename_operand(q->result, fn, instance, &map));
+        }
+    }
+
+    if (exit_label) {
+        emit(out, out_count, OP_LABEL, NULL, NULL, exit_label);
+    }
+    for (int i = 0; i < map.count; i++) {
+        free(map.to[i]);
+    }
+}
+
+// Numbers the copies of parameters; keeps counting across calls so that
+// chunks inlined separately in streaming mode never share a name
+static int instances = 0;
+
+int inline_functions() {
+    int n = quad_count;
+    if (n == 0) return 0;
+
+    // Pair every PARAM with the CALL that consumes it. Arguments of nested
+    // calls are pushed after the outer call's earlier arguments, so a stack
+    // recovers the pairing.
+    int *call_of = malloc(n * sizeof(int));
+    int *param_pos = malloc(n * sizeof(int));
+    int *stack = malloc(n * sizeof(int));
+    SymbolTableEntry **inlined = calloc(n, sizeof(SymbolTableEntry *));
+    int *instance = calloc(n, sizeof(int));
+    int top = 0;
+
+    for (int i = 0; i < n; i++) {
+        call_of[i] = -1;
+        if (quadruples[i].op == OP_PARAM) {
+            stack[top++] = i;
+        } else if (quadruples[i].op == OP_CALL || quadruples[i].op == OP_TAILCALL) {
+            SymbolTableEntry *fn = lookupFunction(quadruples[i].arg1);
+            int nparams = fn ? count_params(fn->params) : 0;
+            for (int pos = nparams - 1; pos >= 0 && top > 0; pos--) {
+                int p = stack[--top];
+                call_of[p] = i;
+                param_pos[p] = pos;
+            }
+        }
+    }
+
+    int projected = n;
+    int sites = 0;
+    for (int i = quad_stream_start; i < n; i++) {
+        if (quadruples[i].op != OP_CALL) continue;
+        SymbolTableEntry *fn = lookupFunction(quadruples[i].arg1);
+        if (!fn || !is_inlinable(fn)) continue;
+        if (i >= fn->quadStart && i < fn->quadEnd) continue;
+        int cost = inline_cost(fn);
+        if (projected + cost - 1 > MAX_QUADS) continue;
+        projected += cost - 1;
+        inlined[i] = fn;
+        instance[i] = ++instances;
+        sites++;
+    }
+
+    if (sites == 0) {
+        free(call_of); free(param_pos); free(stack); free(inlined); free(instance);
+        return 0;
+    }
+
+    Quadruple *out = malloc(MAX_QUADS * sizeof(Quadruple));
+    int *new_index = malloc((n + 1) * sizeof(int));
+    int out_count = 0;
+
+    for (int i = 0; i < n; i++) {
+        Quadruple *q = &quadruples[i];
+        new_index[i] = out_count;
+
+        if (q->op == OP_PARAM && call_of[i] >= 0 && inlined[call_of[i]]) {
+            // Argument is bound where it was pushed so it is evaluated at the same point
+            SymbolTableEntry *fn = inlined[call_of[i]];
+            const Parameter *param = fn->params;
+            for (int pos = 0; pos < param_pos[i]; pos++) param = param->next;
+            emit(out, &out_count, OP_ASSIGN, q->arg1, NULL,
+                 param_copy_name(param->name, instance[call_of[i]]));
+            free(q->arg2);
+            free(q->result);
+        } else if (q->op == OP_CALL && inlined[i]) {
+            emit_body(inlined[i], instance[i], q->result, out, &out_count);
+        } else {
+            out[out_count++] = *q;
+        }
+    }
+    new_index[n] = out_count;
+
+    // Inlined calls are freed last, a body copied later may contain one
+    for (int i = 0; i < n; i++) {
+        if (quadruples[i].op == OP_CALL && inlined[i]) {
+            free(quadruples[i].arg1);
+            free(quadruples[i].arg2);
+            free(quadruples[i].result);
+        }
+    }
+
+    memcpy(quadruples, out, out_count * sizeof(Quadruple));
+    quad_count = out_count;
+    remapFunctionQuadRanges(new_index);
+
+    free(out); free(new_index);
+    free(call_of); free(param_pos); free(stack); free(inlined); free(instance);
+    return sites;
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "quadruple.h"
+#include "ir_binary.h"
+
+// Strings collected while writing, deduplicated through an open-addressing
+// table of indices into the strings array
+typedef struct {
+    const char **strings;
+    uint32_t *offsets;
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t *slots;
+    uint32_t capacity;
+} StringTable;
+
+static uint32_t hash_string(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t intern(StringTable *table, const char *s) {
+    if (!s) return QIR_NONE;
+
+    uint32_t slot = hash_string(s) & (table->capacity - 1);
+    while (table->slots[slot] != QIR_NONE) {
+        uint32_t index = table->slots[slot];
+        if (strcmp(table->strings[index], s) == 0) return index;
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    uint32_t index = table->count++;
+    table->strings[index] = s;
+    table->offsets[index] = table->bytes;
+    table->bytes += strlen(s) + 1;
+    table->slots[slot] = index;
+    return index;
+}
+
+// Strings of the table being written, for sorting the labels by name
+static const char **label_strings;
+
+static int compare_labels(const void *a, const void *b) {
+    const QirLabel *x = a;
+    const QirLabel *y = b;
+    int order = strcmp(label_strings[x->name], label_strings[y->name]);
+    if (order != 0) return order;
+    return x->quad < y->quad ? -1 : x->quad > y->quad;
+}
+
+static uint32_t padded(uint32_t bytes) {
+    return (bytes + 3) & ~3u;
+}
+
+int write_quadruples_binary(const char *filename) {
+    // At most three strings per quad, table kept under half full
+    uint32_t max_strings = 3 * quad_count + 1;
+    StringTable table = { .count = 0, .bytes = 0, .capacity = 16 };
+    while (table.capacity < 2 * max_strings) table.capacity *= 2;
+    table.strings = malloc(max_strings * sizeof(char *));
+    table.offsets = malloc(max_strings * sizeof(uint32_t));
+    table.slots = malloc(table.capacity * sizeof(uint32_t));
+    memset(table.slots, 0xFF, table.capacity * sizeof(uint32_t));
+
+    QirQuad *quads = malloc((quad_count + 1) * sizeof(QirQuad));
+    QirLabel *labels = malloc((quad_count + 1) * sizeof(QirLabel));
+    uint32_t label_count = 0;
+
+    for (int i = 0; i < quad_count; i++) {
+        quads[i].op = quadruples[i].op;
+        quads[i].arg1 = intern(&table, quadruples[i].arg1);
+        quads[i].arg2 = intern(&table, quadruples[i].arg2);
+        quads[i].result = intern(&table, quadruples[i].result);
+        if (quadruples[i].op == OP_LABEL && quads[i].result != QIR_NONE) {
+            labels[label_count].name = quads[i].result;
+            labels[label_count].quad = i;
+            label_count++;
+        }
+    }
+
+    label_strings = table.strings;
+    qsort(labels, label_count, sizeof(QirLabel), compare_labels);
+
+    QirHeader header;
+    memcpy(header.magic, QIR_MAGIC, 4);
+    header.version = QIR_VERSION;
+    header.quad_count = quad_count;
+    header.string_count = table.count;
+    header.string_bytes = padded(table.bytes);
+    header.label_count = label_count;
+
+    int status = -1;
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) {
+        printf("Error opening file %s\n", filename);
+    } else {
+        static const char zeros[4] = { 0 };
+        fwrite(&header, sizeof(header), 1, fp);
+        fwrite(table.offsets, sizeof(uint32_t), table.count, fp);
+        for (uint32_t i = 0; i < table.count; i++) {
+            fwrite(table.strings[i], 1, strlen(table.strings[i]) + 1, fp);
+        }
+        fwrite(zeros, 1, header.string_bytes - table.bytes, fp);
+        fwrite(quads, sizeof(QirQuad), quad_count, fp);
+        fwrite(labels, sizeof(QirLabel), label_count, fp);
+        status = ferror(fp) ? -1 : 0;
+        fclose(fp);
+    }
+
+    free(table.strings);
+    free(table.offsets);
+    free(table.slots);
+    free(quads);
+    free(labels);
+    return status;
+}
+
+static int index_valid(const QirFile *file, uint32_t index) {
+    return index == QIR_NONE || index < file->header->string_count;
+}
+
+// Checks that every section and every reference stays inside the mapping
+static int validate(QirFile *file) {
+    if (file->size < sizeof(QirHeader)) return 0;
+
+    const QirHeader *h = file->header;
+    if (memcmp(h->magic, QIR_MAGIC, 4) != 0 || h->version != QIR_VERSION) return 0;
+
+    uint64_t expected = sizeof(QirHeader)
+                      + (uint64_t)h->string_count * sizeof(uint32_t)
+                      + h->string_bytes
+                      + (uint64_t)h->quad_count * sizeof(QirQuad)
+                      + (uint64_t)h->label_count * sizeof(QirLabel);
+    if (expected != file->size || h->string_bytes % 4 != 0) return 0;
+
+    const char *p = (const char *)file->base + sizeof(QirHeader);
+    file->string_offsets = (const uint32_t *)p;
+    p += h->string_count * sizeof(uint32_t);
+    file->strings = p;
+    p += h->string_bytes;
+    file->quads = (const QirQuad *)p;
+    p += h->quad_count * sizeof(QirQuad);
+    file->labels = (const QirLabel *)p;
+
+    if (h->string_count > 0 && (h->string_bytes == 0 || file->strings[h->string_bytes - 1] != '\0')) return 0;
+    for (uint32_t i = 0; i < h->string_count; i++) {
+        if (file->string_offsets[i] >= h->string_bytes) return 0;
+    }
+    for (uint32_t i = 0; i < h->quad_count; i++) {
+        const QirQuad *q = &file->quads[i];
+        if (q->op >= OP_COUNT || !index_valid(file, q->arg1) ||
+            !index_valid(file, q->arg2) || !index_valid(file, q->result)) return 0;
+    }
+    for (uint32_t i = 0; i < h->label_count; i++) {
+        if (file->labels[i].name >= h->string_count || file->labels[i].quad >= h->quad_count) return 0;
+        if (i > 0 && strcmp(qir_string(file, file->labels[i - 1].name), qir_string(file, file->labels[i].name)) > 0) return 0;
+    }
+    return 1;
+}
+
+int qir_open(const char *filename, QirFile *file) {
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    file->base = base;
+    file->size = st.st_size;
+    file->header = base;
+    if (!validate(file)) {
+        qir_close(file);
+        return -1;
+    }
+    return 0;
+}
+
+void qir_close(QirFile *file) {
+    if (file->base) {
+        munmap(file->base, file->size);
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+const char *qir_string(const QirFile *file, uint32_t index) {
+    return index == QIR_NONE ? NULL : file->strings + file->string_offsets[index];
+}
+
+// Quad index of the LABEL defining name (the first one if repeated), or -1
+int qir_find_label(const QirFile *file, const char *name) {
+    uint32_t low = 0;
+    uint32_t high = file->header->label_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (strcmp(qir_string(file, file->labels[mid].name), name) < 0) low = mid + 1;
+        else high = mid;
+    }
+    if (low < file->header->label_count && strcmp(qir_string(file, file->labels[low].name), name) == 0) {
+        return file->labels[low].quad;
+    }
+    return -1;
+}
+
+static char *copy_string(const QirFile *file, uint32_t index) {
+    const char *s = qir_string(file, index);
+    return s ? strdup(s) : NULL;
+}
+
+int load_quadruples_binary(const char *filename) {
+    QirFile file;
+    if (qir_open(filename, &file) != 0) return -1;
+    if (file.header->quad_count > MAX_QUADS) {
+        qir_close(&file);
+        return -1;
+    }
+
+    free_quadruples();
+    for (uint32_t i = 0; i < file.header->quad_count; i++) {
+        const QirQuad *q = &file.quads[i];
+        quadruples[i].op = q->op;
+        quadruples[i].arg1 = copy_string(&file, q->arg1);
+        quadruples[i].arg2 = copy_string(&file, q->arg2);
+        quadruples[i].result = copy_string(&file, q->result);
+    }
+    quad_count = file.header->quad_count;
+
+    qir_close(&file);
+    return quad_count;
+}
@@ -2,9 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include "parameter.h"
+#include "helpers.h"
 
-Parameter* createParameter(const char *name, const char *type) {
-    if (!name || !type) {
+Parameter* createParameter(const char *name, ValueType type) {
+    if (!name) {
         fprintf(stderr, "Error: Invalid parameters missing name\n");
         return NULL;
     }
@@ -13,7 +14,7 @@ Parameter* createParameter(const char *name, const char *type) {
     if (!param) return NULL;
 
     param->name = strdup(name);
-    param->type = strdup(type);
+    param->type = type;
     param->next = NULL;
     return param;
 }
@@ -39,14 +40,13 @@ void freeParameterList(Parameter *head) {
         Parameter *temp = head;
         head = head->next;
         free(temp->name);
-        free(temp->type);
         free(temp);
     }
 }
 
 void printParameterList(const Parameter *head) {
     while (head) {
-        printf("Param: Name = %s, Type = %s\n", head->name, head->type);
+        printf("Param: Name = %s, Type = %s\n", head->name, typeToString(head->type));
         head = head->next;
     }
 }
@@ -56,7 +56,7 @@ char* parameterListToString(const Parameter* head) {
     buffer[0] = '\0';
 
     while (head) {
-        strcat(buffer, head->type);
+        strcat(buffer, typeToString(head->type));
         strcat(buffer, " ");
         strcat(buffer, head->name);
         if (head->next) strcat(buffer, ", ");
@@ -70,12 +70,65 @@ char* parameterListToString(const Parameter* head) {
     return buffer;
 }
 
-bool compareParameters(Parameter* declared, Parameter* passed) {
-    while (declared && passed) {
-        if (strcmp(declared->type, passed->type) != 0)
-            return false;
-        declared = declared->next;
-        passed = passed->next;
+// Signatures form a trie over parameter types: the signature of
+// (t1, ..., tn) is the child of (t1, ..., tn-1) along tn. The children of
+// all nodes live in one open addressing table keyed on (parent, type).
+typedef struct {
+    int parent;
+    ValueType type;
+    int id;  // 0 marks an empty slot, the empty signature is never stored
+} SignatureSlot;
+
+static SignatureSlot *signatures = NULL;
+static int signatureCapacity = 0;
+static int signatureCount = 0;
+
+static unsigned int signatureHash(int parent, ValueType type) {
+    return ((unsigned int)parent * 8u + (unsigned int)type) * 2654435761u;
+}
+
+static SignatureSlot *findSignatureSlot(int parent, ValueType type) {
+    unsigned int slot = signatureHash(parent, type) & (signatureCapacity - 1);
+    while (signatures[slot].id != 0 &&
+           (signatures[slot].parent != parent || signatures[slot].type != type)) {
+        slot = (slot + 1) & (signatureCapacity - 1);
+    }
+    return &signatures[slot];
+}
+
+static void growSignatures() {
+    SignatureSlot *old = signatures;
+    int oldCapacity = signatureCapacity;
+    signatureCapacity = oldCapacity ? oldCapacity * 2 : 64;
+    signatures = calloc(signatureCapacity, sizeof(SignatureSlot));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i].id != 0) *findSignatureSlot(old[i].parent, old[i].type) = old[i];
+    }
+    free(old);
+}
+
+// Signature of the parameter list of signature followed by one of type
+int extendSignature(int signature, ValueType type) {
+    if ((signatureCount + 1) * 2 > signatureCapacity) growSignatures();
+
+    SignatureSlot *slot = findSignatureSlot(signature, type);
+    if (slot->id == 0) {
+        *slot = (SignatureSlot){ signature, type, ++signatureCount };
+    }
+    return slot->id;
+}
+
+int signatureOf(const Parameter *head) {
+    int signature = EMPTY_SIGNATURE;
+    for (; head; head = head->next) {
+        signature = extendSignature(signature, head->type);
+    }
+    return signature;
+}
+
+void clearSignatures() {
+    if (signatures != NULL) {
+        memset(signatures, 0, signatureCapacity * sizeof(SignatureSlot));
     }
-    return declared == NULL && passed == NULL;
+    signatureCount = 0;
 }
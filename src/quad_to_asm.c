@@ -1,22 +1,37 @@
 #include <stdio.h>
 #include <string.h>
 #include "quadruple.h"
+#include "quad_to_asm.h"
 #define IS_VALID(s) ((s) && strcmp((s), "_") != 0 && strlen((s)) > 0)
 
 static const char* clean(const char* s) {
     return (s && strcmp(s, "_") != 0) ? s : "";
 }
 
+static const char* branch_mnemonic(OpType op) {
+    switch (op) {
+        case OP_IF_LT:  return "JL";
+        case OP_IF_GT:  return "JG";
+        case OP_IF_LTE: return "JLE";
+        case OP_IF_GTE: return "JGE";
+        case OP_IF_EQ:  return "JE";
+        default:        return "JNE";
+    }
+}
+
 void convert_quadruples_to_assembly(const char *filename) {
     FILE *fp = fopen(filename, "w");
     if (!fp) {
         printf("Error opening file %s\n", filename);
         return;
     }
+    write_assembly(fp, 0);
+    fclose(fp);
+}
 
-    char last_jump[128] = "";
-
-    for (int i = 0; i < quad_count; ++i) {
+// Writes the assembly for quads from first on
+void write_assembly(FILE *fp, int first) {
+    for (int i = first; i < quad_count; ++i) {
         Quadruple q = quadruples[i];
         const char *a1 = q.arg1 ? q.arg1 : "_";
         const char *a2 = q.arg2 ? q.arg2 : "_";
@@ -88,12 +103,7 @@ void convert_quadruples_to_assembly(const char *filename) {
                 break;
             case OP_GOTO:
                 if (IS_VALID(res)) {
-                    char jump[128];
-                    snprintf(jump, sizeof(jump), "JMP %s", res);
-                    if (strcmp(jump, last_jump) != 0) {
-                        fprintf(fp, "%s\n", jump);
-                        strcpy(last_jump, jump);
-                    }
+                    fprintf(fp, "JMP %s\n", res);
                 } else {
                     fprintf(fp, ";\n");
                 }
@@ -110,11 +120,25 @@ void convert_quadruples_to_assembly(const char *filename) {
                 else
                     fprintf(fp, ";\n");
                 break;
+            case OP_IF_LT:
+            case OP_IF_GT:
+            case OP_IF_LTE:
+            case OP_IF_GTE:
+            case OP_IF_EQ:
+            case OP_IF_NEQ:
+                if (IS_VALID(res))
+                    fprintf(fp, "%s %s, %s, %s\n", branch_mnemonic(q.op), clean(a1), clean(a2), res);
+                else
+                    fprintf(fp, ";\n");
+                break;
             case OP_CALL:
                 fprintf(fp, "CALL %s\n", clean(a1));
                 if (IS_VALID(res))
                     fprintf(fp, "MOV %s, EAX\n", res);
                 break;
+            case OP_TAILCALL:
+                fprintf(fp, "JMP %s\n", clean(a1));
+                break;
             case OP_RETURN:
                 if (IS_VALID(a1))
                     fprintf(fp, "MOV EAX, %s\n", a1);
@@ -143,6 +167,4 @@ void convert_quadruples_to_assembly(const char *filename) {
                 break;
         }
     }
-
-    fclose(fp);
 }
@@ -5,6 +5,7 @@
 
 Quadruple quadruples[MAX_QUADS];
 int quad_count = 0;
+int quad_stream_start = 0;
 
 int next_temp = 1;
 int next_label = 1;
@@ -41,10 +42,25 @@ const char* get_op_string(OpType op) {
         case OP_FTOI: return "FLOAT_TO_INT";
         case OP_CTOI: return "CHAR_TO_INT";
         case OP_ITOB: return "INT_TO_BOOL";
+        case OP_IF_LT: return "IF_LT";
+        case OP_IF_GT: return "IF_GT";
+        case OP_IF_LTE: return "IF_LTE";
+        case OP_IF_GTE: return "IF_GTE";
+        case OP_IF_EQ: return "IF_EQ";
+        case OP_IF_NEQ: return "IF_NEQ";
+        case OP_TAILCALL: return "TAIL_CALL";
         default: return "UNKNOWN_OP";
     }
 }
 
+// Inverse of get_op_string, returns -1 for an unknown name
+int get_op_from_string(const char *name) {
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (strcmp(get_op_string(op), name) == 0) return op;
+    }
+    return -1;
+}
+
 char* new_temp() {
     char* name = malloc(10);
     snprintf(name, 10, "t%d", next_temp++);
@@ -57,6 +73,56 @@ char* new_label() {
     return label;
 }
 
+static int has_numeric_suffix(const char *name, char prefix) {
+    if (!name || name[0] != prefix || name[1] == '\0') return 0;
+    for (const char *p = name + 1; *p; p++) {
+        if (*p < '0' || *p > '9') return 0;
+    }
+    return 1;
+}
+
+// Names produced by new_temp()
+int is_temp(const char *name) {
+    return has_numeric_suffix(name, 't');
+}
+
+// Names produced by new_label()
+int is_label(const char *name) {
+    return has_numeric_suffix(name, 'L');
+}
+
+int is_compare_branch(OpType op) {
+    return op >= OP_IF_LT && op <= OP_IF_NEQ;
+}
+
+// Branch that jumps when relop holds, or -1 if relop is not a comparison
+int compare_branch_op(OpType relop) {
+    switch (relop) {
+        case OP_LT:  return OP_IF_LT;
+        case OP_GT:  return OP_IF_GT;
+        case OP_LTE: return OP_IF_LTE;
+        case OP_GTE: return OP_IF_GTE;
+        case OP_EQ:  return OP_IF_EQ;
+        case OP_NEQ: return OP_IF_NEQ;
+        default:     return -1;
+    }
+}
+
+// Conditional jump taken exactly when op is not, or -1 for other ops
+int invert_branch(OpType op) {
+    switch (op) {
+        case OP_IFGOTO:  return OP_IFFALSE;
+        case OP_IFFALSE: return OP_IFGOTO;
+        case OP_IF_LT:   return OP_IF_GTE;
+        case OP_IF_GTE:  return OP_IF_LT;
+        case OP_IF_GT:   return OP_IF_LTE;
+        case OP_IF_LTE:  return OP_IF_GT;
+        case OP_IF_EQ:   return OP_IF_NEQ;
+        case OP_IF_NEQ:  return OP_IF_EQ;
+        default:         return -1;
+    }
+}
+
 void add_quadruple(OpType op, const char* arg1, const char* arg2, const char* result) {
     if (quad_count >= MAX_QUADS) {
         fprintf(stderr, "Error: Too many quadruples!\n");
@@ -69,6 +135,32 @@ void add_quadruple(OpType op, const char* arg1, const char* arg2, const char* re
     quad_count++;
 }
 
+PatchList *makelist(int quad) {
+    PatchList *list = malloc(sizeof(PatchList));
+    list->quad = quad;
+    list->next = NULL;
+    return list;
+}
+
+PatchList *merge(PatchList *a, PatchList *b) {
+    if (!a) return b;
+    PatchList *tail = a;
+    while (tail->next) tail = tail->next;
+    tail->next = b;
+    return a;
+}
+
+// Sets the target of every jump in list to label and frees the list
+void backpatch(PatchList *list, const char *label) {
+    while (list) {
+        PatchList *next = list->next;
+        free(quadruples[list->quad].result);
+        quadruples[list->quad].result = strdup(label);
+        free(list);
+        list = next;
+    }
+}
+
 void print_quadruples() {
     printf("\n=== Generated Quadruples ===\n");
     for (int i = 0; i < quad_count; i++) {
@@ -81,6 +173,79 @@ void print_quadruples() {
     }
 }
 
+void write_quadruples_text(FILE *fp) {
+    fprintf(fp, "=== Generated Quadruples ===\n");
+    write_quadruple_range(fp, 0, 0);
+}
+
+// Writes quads from first on, numbering them from number
+void write_quadruple_range(FILE *fp, int first, int number) {
+    for (int i = first; i < quad_count; i++) {
+        fprintf(fp, "[%d] (%s, %s, %s, %s)\n", number++,
+            get_op_string(quadruples[i].op),
+            quadruples[i].arg1 ? quadruples[i].arg1 : "_",
+            quadruples[i].arg2 ? quadruples[i].arg2 : "_",
+            quadruples[i].result ? quadruples[i].result : "_"
+        );
+    }
+}
+
+// Splits the next ", "-separated field off *p into *field, leaving string
+// and char literals intact. "_" stands for an empty operand and gives NULL.
+// Returns -1 if the line has no field left.
+static int next_field(char **p, char terminator, char **field) {
+    char *start = *p;
+    char quote = 0;
+    char *s = start;
+    for (; *s; s++) {
+        if (quote) {
+            if (*s == '\\' && s[1]) s++;
+            else if (*s == quote) quote = 0;
+        } else if (*s == '"' || *s == '\'') {
+            quote = *s;
+        } else if ((*s == ',' && s[1] == ' ') || (*s == terminator && (s[1] == '\0' || s[1] == '\n' || s[1] == '\r'))) {
+            break;
+        }
+    }
+    if (!*s) return -1;
+
+    int is_last = (*s == terminator);
+    *s = '\0';
+    *p = is_last ? s + 1 : s + 2;
+    *field = strcmp(start, "_") == 0 ? NULL : strdup(start);
+    return 0;
+}
+
+// Reads quadruples in the format produced by write_quadruples_text,
+// replacing the current list. Returns the number read, or -1 on a bad line.
+int read_quadruples_text(FILE *fp) {
+    char line[1024];
+    free_quadruples();
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = strchr(line, '(');
+        if (line[0] != '[' || !p) continue;  // header or blank line
+        if (quad_count >= MAX_QUADS) return -1;
+        p++;
+
+        char *op_name = NULL;
+        int op = next_field(&p, ')', &op_name) == 0 && op_name ? get_op_from_string(op_name) : -1;
+        free(op_name);
+        if (op < 0) return -1;
+
+        Quadruple *q = &quadruples[quad_count];
+        q->op = op;
+        q->arg1 = q->arg2 = q->result = NULL;
+        if (next_field(&p, ')', &q->arg1) != 0 || next_field(&p, ')', &q->arg2) != 0 ||
+            next_field(&p, ')', &q->result) != 0) {
+            free(q->arg1);
+            free(q->arg2);
+            return -1;
+        }
+        quad_count++;
+    }
+    return quad_count;
+}
+
 void free_quadruples() {
     for (int i = 0; i < quad_count; i++) {
         free(quadruples[i].arg1);
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quadruple.h"
+#include "quad_to_asm.h"
+#include "symbol_table.h"
+#include "error_handler.h"
+#include "inliner.h"
+#include "tail_calls.h"
+#include "gvn.h"
+#include "block_layout.h"
+#include "stream.h"
+
+static int active = 0;
+static const char *quad_path;
+static const char *asm_path;
+static FILE *quad_out = NULL;
+static FILE *asm_out = NULL;
+static FILE *symbol_out = NULL;
+static int written = 0;   // quads written so far, numbers the next one
+static int inlined = 0;
+static int value_numbered = 0;
+static LayoutStats layout;
+
+void stream_begin(const char *quad_file, const char *asm_file, const char *symbol_file) {
+    quad_path = quad_file;
+    asm_path = asm_file;
+    quad_out = fopen(quad_file, "w");
+    asm_out = fopen(asm_file, "w");
+    symbol_out = fopen(symbol_file, "w");
+    if (!quad_out || !asm_out || !symbol_out) {
+        printf("Error opening output files for streaming\n");
+    }
+    if (quad_out) fprintf(quad_out, "=== Generated Quadruples ===\n");
+    written = 0;
+    inlined = 0;
+    value_numbered = 0;
+    layout.takenBefore = layout.takenAfter = 0;
+    active = 1;
+}
+
+int stream_active() {
+    return active;
+}
+
+// Drops the quads of the chunk just written, except for the bodies of
+// small global functions, which move down to the kept prefix while it has
+// room. Functions whose body is gone lose their quad range.
+static void keep_small_functions() {
+    int from = quad_stream_start;
+    char *keep = calloc(quad_count - from + 1, 1);
+
+    int count;
+    SymbolTableEntry **functions = collectFunctions(&count);
+    int kept = from;
+    for (int i = 0; i < count; i++) {
+        SymbolTableEntry *fn = functions[i];
+        if (fn->quadStart < from) continue;
+        int size = fn->quadEnd - fn->quadStart;
+        if (size - 1 <= INLINE_MAX_BODY_QUADS && kept + size <= STREAM_KEPT_QUADS) {
+            memset(keep + fn->quadStart - from, 1, size);
+            fn->quadEnd = kept + size;
+            fn->quadStart = kept;
+            kept += size;
+        } else {
+            fn->quadStart = -1;
+            fn->quadEnd = -1;
+        }
+    }
+
+    int out = from;
+    for (int i = from; i < quad_count; i++) {
+        if (keep[i - from]) {
+            quadruples[out++] = quadruples[i];
+        } else {
+            free(quadruples[i].arg1);
+            free(quadruples[i].arg2);
+            free(quadruples[i].result);
+        }
+    }
+    quad_count = quad_stream_start = out;
+
+    free(functions);
+    free(keep);
+}
+
+void stream_flush() {
+    if (!active) return;
+
+    if (quad_count > quad_stream_start && get_error_count() == 0) {
+        inlined += inline_functions();
+        convert_tail_calls();
+        // Per-function reports would repeat for every chunk, only the totals are printed
+        value_numbered += global_value_numbering(0);
+        layout_blocks(&layout, 0);
+        if (quad_out) write_quadruple_range(quad_out, quad_stream_start, written);
+        if (asm_out) write_assembly(asm_out, quad_stream_start);
+        written += quad_count - quad_stream_start;
+    }
+    releaseLocalScopes(symbol_out);
+    keep_small_functions();
+}
+
+void stream_end() {
+    if (!active) return;
+    stream_flush();
+    active = 0;
+
+    if (quad_out) fclose(quad_out);
+    if (asm_out) fclose(asm_out);
+    quad_out = asm_out = NULL;
+
+    if (get_error_count() > 0) {
+        // Chunks written before the first error are not a usable program
+        fclose(fopen(quad_path, "w"));
+        fclose(fopen(asm_path, "w"));
+    } else {
+        if (inlined > 0) {
+            printf("Inlined %d call site(s)\n", inlined);
+        }
+        if (value_numbered > 0) {
+            printf("Value numbering removed %d quad(s)\n", value_numbered);
+        }
+        printf("Taken jumps (estimated): %.1f before block layout, %.1f after\n",
+               layout.takenBefore, layout.takenAfter);
+        printf("Quadruples written to %s\n", quad_path);
+        printf("Assembly code written to %s\n", asm_path);
+    }
+
+    if (symbol_out) {
+        writeSymbolTableOfAllScopesToFile(symbol_out);
+        fclose(symbol_out);
+        symbol_out = NULL;
+    }
+}
@@ -1,32 +1,204 @@
 #include "symbol_table.h"
 #include "error_handler.h"
+#include "arena.h"
 
 Scope *currentScope = NULL;
-Scope *allScopes[1000];     
+Scope **allScopes = NULL;   // every scope in creation order
 int scopeCount = 0;    
+static int scopeCapacity = 0;
 int scope_depth = 0;  // Add scope depth tracking
 
+// Scopes, entries, names and parameter lists live here and are released
+// together by clearSymbolTables. Everything created while a nested scope
+// is open goes to localArena instead, which releaseLocalScopes can drop
+// on its own.
+static Arena symbolArena = { NULL, ARENA_DEFAULT_CHUNK_SIZE };
+static Arena localArena = { NULL, ARENA_DEFAULT_CHUNK_SIZE };
+
+// Scopes released so far, so that scope numbers keep counting up
+static int releasedScopes = 0;
+
+// Every function symbol, in declaration order, so that passes over the
+// generated functions do not have to walk every symbol of every scope
+typedef struct {
+    SymbolTableEntry *entry;
+    int scope;   // position of its scope in allScopes
+} FunctionRef;
+
+static FunctionRef *functionRefs = NULL;
+static int functionRefCount = 0;
+static int functionRefCapacity = 0;
+
 extern int prev_valid_line;
 
+// Every identifier is stored once; scopes compare names by pointer
+typedef struct InternedName {
+    struct InternedName *next;
+    unsigned int hash;
+    char name[];
+} InternedName;
+
+static InternedName **internTable = NULL;
+static int internTableSize = 0;
+static int internCount = 0;
+
+// Names interned in localArena, unlinked again when it is released
+static InternedName **localNames = NULL;
+static int localNameCount = 0;
+static int localNameCapacity = 0;
+
+#define SCOPE_INDEX_MIN_SIZE 8
+
+static Arena *arenaFor(Scope *scope) {
+    return (scope == NULL || scope->parent == NULL) ? &symbolArena : &localArena;
+}
+
+static unsigned int hashName(const char *name) {
+    unsigned int hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+static InternedName *findInterned(const char *name, unsigned int hash) {
+    if (internTableSize == 0) return NULL;
+    InternedName *entry = internTable[hash & (internTableSize - 1)];
+    while (entry && (entry->hash != hash || strcmp(entry->name, name) != 0)) {
+        entry = entry->next;
+    }
+    return entry;
+}
+
+static void growInternTable() {
+    int newSize = internTableSize ? internTableSize * 2 : 256;
+    InternedName **table = calloc(newSize, sizeof(InternedName *));
+    if (table == NULL) {
+        printf("Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < internTableSize; i++) {
+        InternedName *entry = internTable[i];
+        while (entry) {
+            InternedName *next = entry->next;
+            int slot = entry->hash & (newSize - 1);
+            entry->next = table[slot];
+            table[slot] = entry;
+            entry = next;
+        }
+    }
+    free(internTable);
+    internTable = table;
+    internTableSize = newSize;
+}
+
+static InternedName *intern(const char *name) {
+    unsigned int hash = hashName(name);
+    InternedName *entry = findInterned(name, hash);
+    if (entry) return entry;
+
+    if (internCount >= internTableSize) {
+        growInternTable();
+    }
+    size_t len = strlen(name) + 1;
+    Arena *arena = arenaFor(currentScope);
+    entry = arena_alloc(arena, sizeof(InternedName) + len);
+    entry->hash = hash;
+    memcpy(entry->name, name, len);
+    int slot = hash & (internTableSize - 1);
+    entry->next = internTable[slot];
+    internTable[slot] = entry;
+    internCount++;
+
+    if (arena == &localArena) {
+        if (localNameCount == localNameCapacity) {
+            localNameCapacity = localNameCapacity ? localNameCapacity * 2 : 64;
+            localNames = realloc(localNames, localNameCapacity * sizeof(InternedName *));
+        }
+        localNames[localNameCount++] = entry;
+    }
+    return entry;
+}
+
+// Returns the shared copy of name, valid until clearSymbolTables
+const char *internName(const char *name) {
+    return intern(name)->name;
+}
+
+static SymbolTableEntry *findInScope(Scope *scope, const char *name, unsigned int hash) {
+    if (scope->indexSize == 0) return NULL;
+    SymbolTableEntry *symbol = scope->index[hash & (scope->indexSize - 1)];
+    while (symbol && symbol->identifierName != name) {
+        symbol = symbol->hashNext;
+    }
+    return symbol;
+}
+
+static void indexSymbol(Scope *scope, SymbolTableEntry *entry) {
+    if (scope->symbolCount >= scope->indexSize) {
+        // Old buckets stay in the arena until the next reset
+        int newSize = scope->indexSize ? scope->indexSize * 2 : SCOPE_INDEX_MIN_SIZE;
+        SymbolTableEntry **index = arena_alloc(arenaFor(scope), newSize * sizeof(SymbolTableEntry *));
+        memset(index, 0, newSize * sizeof(SymbolTableEntry *));
+        for (SymbolTableEntry *symbol = scope->symbols; symbol != NULL; symbol = symbol->next) {
+            int slot = symbol->nameHash & (newSize - 1);
+            symbol->hashNext = index[slot];
+            index[slot] = symbol;
+        }
+        scope->index = index;
+        scope->indexSize = newSize;
+    }
+    int slot = entry->nameHash & (scope->indexSize - 1);
+    entry->hashNext = scope->index[slot];
+    scope->index[slot] = entry;
+    scope->symbolCount++;
+}
+
+static Scope *createScope(Scope *parent) {
+    if (scopeCount == scopeCapacity) {
+        scopeCapacity = scopeCapacity ? scopeCapacity * 2 : 64;
+        allScopes = realloc(allScopes, scopeCapacity * sizeof(Scope *));
+        if (allScopes == NULL) {
+            printf("Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    Scope *scope = arena_alloc(parent == NULL ? &symbolArena : &localArena, sizeof(Scope));
+    scope->symbols = NULL;
+    scope->tail = NULL;
+    scope->index = NULL;
+    scope->indexSize = 0;
+    scope->symbolCount = 0;
+    scope->position = scopeCount;
+    scope->parent = parent;
+    allScopes[scopeCount++] = scope;
+    return scope;
+}
+
+static Parameter *copyParams(const Parameter *param) {
+    Parameter *head = NULL;
+    Parameter **link = &head;
+    while (param) {
+        Parameter *copy = arena_alloc(arenaFor(currentScope), sizeof(Parameter));
+        copy->name = arena_strdup(arenaFor(currentScope), param->name);
+        copy->type = param->type;
+        copy->next = NULL;
+        *link = copy;
+        link = &copy->next;
+        param = param->next;
+    }
+    return head;
+}
+
 void initSymbolTable() {
     if (currentScope == NULL) {
-        currentScope = (Scope *)malloc(sizeof(Scope));
-        currentScope->symbols = NULL;
-        currentScope->parent = NULL;
-
-        allScopes[scopeCount] = currentScope;
-        scopeCount++;
+        currentScope = createScope(NULL);
     }
 }
 
 void enterScope() {
-    Scope *newScope = (Scope *)malloc(sizeof(Scope));
-    newScope->symbols = NULL;
-    newScope->parent = currentScope;
-    currentScope = newScope;
-
-    allScopes[scopeCount] = newScope;
-    scopeCount++;
+    currentScope = createScope(currentScope);
 }
 
 void addScope()
@@ -44,79 +216,140 @@ void exitScope() {
     currentScope = currentScope->parent;
 }
 
-void *addSymbol(char *name, char *type, bool isIntialized, Value value, bool isConst, bool isFunction, Parameter *params) {
+void *addSymbol(const char *name, ValueType type, bool isIntialized, Value value, bool isConst, bool isFunction, Parameter *params) {
     if (currentScope == NULL) {
         initSymbolTable();
     }
 
-    if (name == NULL || type == NULL) {
-        report_error(SEMANTIC_ERROR, "Invalid Parameters", prev_valid_line);
-        fprintf(stderr, "Semantic Error (line %d): Symbol name or type is NULL.\n", prev_valid_line);
+    if (name == NULL) {
+        report_diagnostic(SEMANTIC_ERROR, "Invalid Parameters", prev_valid_line, NULL, "Symbol name is NULL.");
         return NULL;
     }
 
     if (isSymbolDeclaredInCurrentScope(name)) {
-        report_error(SEMANTIC_ERROR, "Variable Redeclaration", prev_valid_line);
-        fprintf(stderr, "Semantic Error (line %d): Identifier '%s' is already defined in the current scope.\n", prev_valid_line, name);
+        report_diagnostic(SEMANTIC_ERROR, "Variable Redeclaration", prev_valid_line, name, "Identifier '%s' is already defined in the current scope.", name);
         return NULL;
     }
 
 
-    SymbolTableEntry *newEntry = (SymbolTableEntry *)malloc(sizeof(SymbolTableEntry));
-    if (newEntry == NULL) {
-        printf("Error: Memory allocation failed\n");
-        return NULL;
-    }
+    SymbolTableEntry *newEntry = arena_alloc(arenaFor(currentScope), sizeof(SymbolTableEntry));
 
-    newEntry->identifierName = strdup(name);
-    newEntry->type = mapStringToValueType(type);
+    InternedName *interned = intern(name);
+    newEntry->identifierName = interned->name;
+    newEntry->nameHash = interned->hash;
+    newEntry->type = type;
     newEntry->isConst = isConst;
     newEntry->isInitialized = isIntialized; 
     newEntry->isUsed = false;
     newEntry->isFunction = isFunction;
-    newEntry->params = params;
+    newEntry->params = copyParams(params);
+    newEntry->signature = isFunction ? signatureOf(params) : EMPTY_SIGNATURE;
+    newEntry->line = prev_valid_line;
+    newEntry->quadStart = -1;
+    newEntry->quadEnd = -1;
     newEntry->value = value;
     newEntry->next = NULL;
 
     // Add to current scope
+    indexSymbol(currentScope, newEntry);
     if (currentScope->symbols == NULL) {
         currentScope->symbols = newEntry;
     } else {
-        SymbolTableEntry *temp = currentScope->symbols;
-        while (temp->next != NULL) {
-            temp = temp->next;
+        currentScope->tail->next = newEntry;
+    }
+    currentScope->tail = newEntry;
+
+    if (isFunction) {
+        if (functionRefCount == functionRefCapacity) {
+            functionRefCapacity = functionRefCapacity ? functionRefCapacity * 2 : 16;
+            functionRefs = realloc(functionRefs, functionRefCapacity * sizeof(FunctionRef));
         }
-        temp->next = newEntry;
+        functionRefs[functionRefCount].entry = newEntry;
+        functionRefs[functionRefCount].scope = currentScope->position;
+        functionRefCount++;
     }
 
     return newEntry;
 }
 
 SymbolTableEntry *lookupSymbol(char *name) {
-    Scope *scope = currentScope;
-    while (scope != NULL) {
-        SymbolTableEntry *symbol = scope->symbols;
-        while (symbol != NULL) {
-            if (strcmp(symbol->identifierName, name) == 0) {
-                return symbol;
-            }
-            symbol = symbol->next;
+    unsigned int hash = hashName(name);
+    InternedName *interned = findInterned(name, hash);
+    if (interned == NULL) return NULL;  // never declared anywhere
+
+    for (Scope *scope = currentScope; scope != NULL; scope = scope->parent) {
+        SymbolTableEntry *symbol = findInScope(scope, interned->name, hash);
+        if (symbol != NULL) {
+            return symbol;
         }
-        scope = scope->parent;
     }
     return NULL;
 }
 
+// Searches every scope (not just the visible chain) so passes that run after
+// parsing can still find nested functions
+SymbolTableEntry *lookupFunction(const char *name) {
+    unsigned int hash = hashName(name);
+    InternedName *interned = findInterned(name, hash);
+    if (interned == NULL || scopeCount == 0) return NULL;
+
+    SymbolTableEntry *symbol = findInScope(allScopes[0], interned->name, hash);
+    if (symbol != NULL && symbol->isFunction) return symbol;
+
+    // Nested functions: the one in the outermost scope wins
+    SymbolTableEntry *found = NULL;
+    int foundScope = scopeCount;
+    for (int i = 0; i < functionRefCount; i++) {
+        if (functionRefs[i].entry->identifierName == interned->name && functionRefs[i].scope < foundScope) {
+            found = functionRefs[i].entry;
+            foundScope = functionRefs[i].scope;
+        }
+    }
+    return found;
+}
+
+// Called by passes that rewrite the quad array; newIndex[old] is the new
+// position of quad old (or of the next surviving quad if it was removed)
+void remapFunctionQuadRanges(const int *newIndex) {
+    for (int i = 0; i < functionRefCount; i++) {
+        SymbolTableEntry *symbol = functionRefs[i].entry;
+        if (symbol->quadStart >= 0) {
+            symbol->quadStart = newIndex[symbol->quadStart];
+            symbol->quadEnd = newIndex[symbol->quadEnd];
+        }
+    }
+}
+
+// Functions that have generated code, grouped by scope. The caller
+// frees the returned array.
+SymbolTableEntry **collectFunctions(int *count) {
+    SymbolTableEntry **functions = malloc((functionRefCount + 1) * sizeof(SymbolTableEntry *));
+    int *scopes = malloc((functionRefCount + 1) * sizeof(int));
+    *count = 0;
+    for (int i = 0; i < functionRefCount; i++) {
+        if (functionRefs[i].entry->quadStart < 0) continue;
+        // Insertion sort on the scope, nearly everything is in scope 0
+        int pos = (*count)++;
+        while (pos > 0 && scopes[pos - 1] > functionRefs[i].scope) {
+            functions[pos] = functions[pos - 1];
+            scopes[pos] = scopes[pos - 1];
+            pos--;
+        }
+        functions[pos] = functionRefs[i].entry;
+        scopes[pos] = functionRefs[i].scope;
+    }
+    free(scopes);
+    return functions;
+}
+
 int updateSymbolValue(char *name, Value newValue) {
     SymbolTableEntry *symbol = lookupSymbol(name);
     if (symbol == NULL) {
-        report_error(SEMANTIC_ERROR, "Undeclared Variable", prev_valid_line);
-        fprintf(stderr, "Semantic Error (line %d): Variable '%s' is not declared.\n", prev_valid_line, name);
+        report_diagnostic(SEMANTIC_ERROR, "Undeclared Variable", prev_valid_line, name, "Variable '%s' is not declared.", name);
         return -1;
     }
     if (symbol->isConst && symbol->isInitialized) {
-        report_error(SEMANTIC_ERROR, "Constant Reassignment", prev_valid_line);
-        fprintf(stderr, "Semantic Error (line %d): Cannot update value of constant symbol '%s'.\n", prev_valid_line, name);
+        report_diagnostic(SEMANTIC_ERROR, "Constant Reassignment", prev_valid_line, name, "Cannot update value of constant symbol '%s'.", name);
         return 0;
     }
     symbol->value = newValue;
@@ -124,21 +357,21 @@ int updateSymbolValue(char *name, Value newValue) {
     return 0;
 }
 
-bool isSymbolDeclaredInCurrentScope(char *name) {
-    SymbolTableEntry *symbol = currentScope->symbols;
-    while (symbol != NULL) {
-        if (strcmp(symbol->identifierName, name) == 0) {
-            return true;
-        }
-        symbol = symbol->next;
-    }
-    return false;
+bool isSymbolDeclaredInCurrentScope(const char *name) {
+    unsigned int hash = hashName(name);
+    InternedName *interned = findInterned(name, hash);
+    return interned != NULL && findInScope(currentScope, interned->name, hash) != NULL;
 }
 
-void writeSymbolTableOfAllScopesToFile(FILE *file) {
-    for (int i = 0; i < scopeCount; i++) {
+// Number of allScopes[i] in the symbol table file and in warnings
+static int scopeLevel(int i) {
+    return i == 0 ? 0 : i + releasedScopes;
+}
+
+static void writeScopes(FILE *file, int from, int to) {
+    for (int i = from; i < to; i++) {
         Scope *scope = allScopes[i];
-        fprintf(file, "=== Scope Level: %d ===\n", i);
+        fprintf(file, "=== Scope Level: %d ===\n", scopeLevel(i));
 
         SymbolTableEntry *symbol = scope->symbols;
         while (symbol != NULL) {
@@ -162,32 +395,73 @@ void writeSymbolTableOfAllScopesToFile(FILE *file) {
     }
 }
 
-void clearSymbolTables(Scope *scope) {
-    if (scope == NULL) return;
-    SymbolTableEntry *symbol = scope->symbols;
-    while (symbol != NULL) {
-        SymbolTableEntry *temp = symbol;
-        symbol = symbol->next;
-        free(temp->identifierName);
-        free(temp);
-    }
-    if (scope->parent) {
-        clearSymbolTables(scope->parent);
+void writeSymbolTableOfAllScopesToFile(FILE *file) {
+    writeScopes(file, 0, scopeCount);
+}
+
+static void reportUnusedInScopes(int from, int to) {
+    for (int i = from; i < to; i++) {
+        Scope *scope = allScopes[i];
+        SymbolTableEntry *symbol = scope->symbols;
+        while (symbol != NULL) {
+            if (!symbol->isUsed && !symbol->isFunction) {
+                report_diagnostic(SEMANTIC_WARNING, "Unused Variable", symbol->line, symbol->identifierName,
+                        "Variable '%s' declared in scope %d but never used.", symbol->identifierName, scopeLevel(i));
+            }
+            symbol = symbol->next;
+        }
     }
-    free(scope);
 }
 
-ValueType mapStringToValueType(const char *typeStr) {
-    if (strcmp(typeStr, "int") == 0) return INT_TYPE;
-    if (strcmp(typeStr, "float") == 0) return FLOAT_TYPE;
-    if (strcmp(typeStr, "string") == 0) return STRING_TYPE;
-    if (strcmp(typeStr, "bool") == 0) return BOOL_TYPE;
-    if (strcmp(typeStr, "char") == 0) return CHAR_TYPE;
-    if (strcmp(typeStr, "void") == 0) return VOID_TYPE;
+// Streaming mode: once a top-level statement is complete, the scopes it
+// opened are written to file, their unused variables reported and their
+// memory released. Only the global scope and the names it uses remain.
+void releaseLocalScopes(FILE *file) {
+    if (scopeCount == 0 || currentScope != allScopes[0]) return;
+
+    // Nested functions go away with their scopes, global ones once their
+    // code was released
+    int kept = 0;
+    for (int i = 0; i < functionRefCount; i++) {
+        if (functionRefs[i].scope == 0 && functionRefs[i].entry->quadStart >= 0) {
+            functionRefs[kept++] = functionRefs[i];
+        }
+    }
+    functionRefCount = kept;
+
+    if (scopeCount == 1) return;
+
+    if (file) writeScopes(file, 1, scopeCount);
+    reportUnusedInScopes(1, scopeCount);
+    releasedScopes += scopeCount - 1;
+    scopeCount = 1;
 
-    report_error(SEMANTIC_ERROR, "Unknown Type", prev_valid_line);
-    fprintf(stderr, "Semantic Error (line %d): Unknown type string '%s'.\n", prev_valid_line, typeStr);
-    exit(EXIT_FAILURE);
+    for (int i = 0; i < localNameCount; i++) {
+        InternedName **link = &internTable[localNames[i]->hash & (internTableSize - 1)];
+        while (*link != localNames[i]) link = &(*link)->next;
+        *link = localNames[i]->next;
+    }
+    internCount -= localNameCount;
+    localNameCount = 0;
+    arena_reset(&localArena);
+}
+
+// Releases every scope at once; the registry keeps its capacity so the
+// next compile reuses it
+void clearSymbolTables() {
+    arena_reset(&symbolArena);
+    arena_reset(&localArena);
+    localNameCount = 0;
+    releasedScopes = 0;
+    functionRefCount = 0;
+    clearSignatures();
+    if (internTable != NULL) {
+        memset(internTable, 0, internTableSize * sizeof(InternedName *));
+    }
+    internCount = 0;
+    scopeCount = 0;
+    scope_depth = 0;
+    currentScope = NULL;
 }
 
 const char *valueTypeToString(ValueType type) {
@@ -213,7 +487,8 @@ void handleDec(char *identifier) {
     } else if (entry->type == FLOAT_TYPE) {
         entry->value.fVal -= 1;
     } else {
-        printf("Error: DEC operation is not supported for type '%s'.\n", valueTypeToString(entry->type));
+        report_diagnostic(SEMANTIC_ERROR, "Invalid Operand Type", prev_valid_line, identifier,
+                "DEC operation is not supported for type '%s'.", valueTypeToString(entry->type));
         return;
     }
     updateSymbolValue(identifier, entry->value);
@@ -231,7 +506,8 @@ void handleInc(char *identifier) {
     } else if (entry->type == FLOAT_TYPE) {
         entry->value.fVal += 1;
     } else {
-        printf("Error: INC operation is not supported for type '%s'.\n", valueTypeToString(entry->type));
+        report_diagnostic(SEMANTIC_ERROR, "Invalid Operand Type", prev_valid_line, identifier,
+                "INC operation is not supported for type '%s'.", valueTypeToString(entry->type));
         return;
     }
 
@@ -241,13 +517,14 @@ void handleInc(char *identifier) {
 void addParamsToSymbolTable(const Parameter* head) {
     const Parameter* param = head;
     while (param) {
-        if (!param->name || !param->type) {
-            fprintf(stderr, "Error: Invalid parameter with missing name or type\n");
+        if (!param->name) {
+            fprintf(stderr, "Error: Invalid parameter with missing name\n");
             return;
         }
 
         if (isSymbolDeclaredInCurrentScope(param->name)) {
-            fprintf(stderr, "Semantic Error: Parameter '%s' already declared in this scope.\n", param->name);
+            report_diagnostic(SEMANTIC_ERROR, "Parameter Redeclaration", prev_valid_line, param->name,
+                    "Parameter '%s' already declared in this scope.", param->name);
         } else {
             Value val = {0};
             addSymbol(param->name, param->type, true, val, false, false, NULL);
@@ -270,14 +547,5 @@ void checkUnclosedScopes(int yylineno)
 }
 
 void reportUnusedVariables() {
-    for (int i = 0; i < scopeCount; i++) {
-        Scope *scope = allScopes[i];
-        SymbolTableEntry *symbol = scope->symbols;
-        while (symbol != NULL) {
-            if (!symbol->isUsed && !symbol->isFunction) {
-                printf("Semantic Warning: Variable '%s' declared in scope %d but never used.\n", symbol->identifierName, i);
-            }
-            symbol = symbol->next;
-        }
-    }
+    reportUnusedInScopes(0, scopeCount);
 }
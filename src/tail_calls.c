@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "quadruple.h"
+#include "symbol_table.h"
+#include "tail_calls.h"
+
+static int count_params(const Parameter *param) {
+    int count = 0;
+    for (; param; param = param->next) count++;
+    return count;
+}
+
+// Temps and literals keep their value until the jump, variables may not
+static int is_variable(const char *s) {
+    return s && !is_temp(s) && (isalpha((unsigned char)s[0]) || s[0] == '_');
+}
+
+// Whether the argument pushed by quad must be copied to a temp where it
+// was pushed: it reads a parameter that is assigned before it, or a
+// variable that a call between the push and the tail call may change
+static int needs_copy(const Parameter *params, int pos, int quad, int call) {
+    const char *arg = quadruples[quad].arg1;
+    if (!is_variable(arg)) return 0;
+    for (const Parameter *p = params; p && pos > 0; p = p->next, pos--) {
+        if (strcmp(p->name, arg) == 0) return 1;
+    }
+    for (int i = quad + 1; i < call; i++) {
+        if (quadruples[i].op == OP_CALL) return 1;
+    }
+    return 0;
+}
+
+static void emit(Quadruple *out, int *out_count, OpType op, char *arg1, char *arg2, char *result) {
+    out[*out_count].op = op;
+    out[*out_count].arg1 = arg1;
+    out[*out_count].arg2 = arg2;
+    out[*out_count].result = result;
+    (*out_count)++;
+}
+
+static void free_quad(Quadruple *q) {
+    free(q->arg1);
+    free(q->arg2);
+    free(q->result);
+}
+
+int convert_tail_calls() {
+    int n = quad_count;
+    if (n == 0) return 0;
+
+    // Innermost function around every quad; nested functions come later
+    int fnCount;
+    SymbolTableEntry **functions = collectFunctions(&fnCount);
+    SymbolTableEntry **owner = calloc(n, sizeof(SymbolTableEntry *));
+    for (int f = 0; f < fnCount; f++) {
+        for (int i = functions[f]->quadStart; i < functions[f]->quadEnd && i < n; i++) {
+            owner[i] = functions[f];
+        }
+    }
+    free(functions);
+
+    // Pair every PARAM with the CALL that consumes it, as the inliner does
+    int *call_of = malloc(n * sizeof(int));
+    int *param_pos = malloc(n * sizeof(int));
+    int *stack = malloc(n * sizeof(int));
+    int top = 0;
+    for (int i = 0; i < n; i++) {
+        call_of[i] = -1;
+        if (quadruples[i].op == OP_PARAM) {
+            stack[top++] = i;
+        } else if (quadruples[i].op == OP_CALL || quadruples[i].op == OP_TAILCALL) {
+            SymbolTableEntry *fn = lookupFunction(quadruples[i].arg1);
+            int nparams = fn ? count_params(fn->params) : 0;
+            for (int pos = nparams - 1; pos >= 0 && top > 0; pos--) {
+                int p = stack[--top];
+                call_of[p] = i;
+                param_pos[p] = pos;
+            }
+        }
+    }
+
+    // A call whose value is returned by the next quad can jump, provided
+    // all of its arguments were found and the copies still fit
+    SymbolTableEntry **callee = calloc(n, sizeof(SymbolTableEntry *));
+    char *copy = calloc(n, 1);
+    int projected = n;
+    int converted = 0;
+    for (int i = quad_stream_start; i + 1 < n; i++) {
+        Quadruple *q = &quadruples[i];
+        Quadruple *ret = &quadruples[i + 1];
+        if (q->op != OP_CALL || !q->result || ret->op != OP_RETURN || !ret->arg1 ||
+            strcmp(q->result, ret->arg1) != 0 || !owner[i]) {
+            continue;
+        }
+        SymbolTableEntry *fn = lookupFunction(q->arg1);
+        if (!fn) continue;
+
+        int found = 0;
+        int copies = 0;
+        for (int p = owner[i]->quadStart; p < i; p++) {
+            if (call_of[p] != i) continue;
+            found++;
+            copies += needs_copy(fn->params, param_pos[p], p, i);
+        }
+        if (found != count_params(fn->params) || projected + copies - 1 > MAX_QUADS) continue;
+
+        for (int p = owner[i]->quadStart; p < i; p++) {
+            if (call_of[p] == i) copy[p] = needs_copy(fn->params, param_pos[p], p, i);
+        }
+        projected += copies - 1;
+        callee[i] = fn;
+        converted++;
+    }
+
+    if (converted == 0) {
+        free(owner); free(call_of); free(param_pos); free(stack); free(callee); free(copy);
+        return 0;
+    }
+
+    Quadruple *out = malloc(MAX_QUADS * sizeof(Quadruple));
+    char **source = calloc(n, sizeof(char *));  // value of each argument, by PARAM
+    int *new_index = malloc((n + 1) * sizeof(int));
+    int out_count = 0;
+
+    for (int i = 0; i < n; i++) {
+        Quadruple *q = &quadruples[i];
+        new_index[i] = out_count;
+
+        if (q->op == OP_PARAM && call_of[i] >= 0 && callee[call_of[i]]) {
+            // Copies are taken where the argument was pushed, the other
+            // pushes are dropped and their operand assigned directly
+            if (copy[i]) {
+                source[i] = new_temp();
+                emit(out, &out_count, OP_ASSIGN, q->arg1, NULL, strdup(source[i]));
+            } else {
+                source[i] = q->arg1;
+            }
+            free(q->arg2);
+            free(q->result);
+        } else if (q->op == OP_CALL && callee[i]) {
+            SymbolTableEntry *fn = callee[i];
+            int pos = 0;
+            for (const Parameter *param = fn->params; param; param = param->next, pos++) {
+                int p = i - 1;
+                while (call_of[p] != i || param_pos[p] != pos) p--;
+                if (source[p] && strcmp(source[p], param->name) != 0) {
+                    emit(out, &out_count, OP_ASSIGN, source[p], NULL, strdup(param->name));
+                } else {
+                    free(source[p]);
+                }
+            }
+            if (fn == owner[i]) {
+                // Recursion becomes a loop back to the function label
+                emit(out, &out_count, OP_GOTO, NULL, NULL, strdup(fn->identifierName));
+                free(q->arg1);
+            } else {
+                emit(out, &out_count, OP_TAILCALL, q->arg1, NULL, NULL);
+            }
+            free(q->arg2);
+            free(q->result);
+
+            // The RETURN of the call's value is never reached
+            new_index[++i] = out_count;
+            free_quad(&quadruples[i]);
+        } else {
+            out[out_count++] = *q;
+        }
+    }
+    new_index[n] = out_count;
+
+    memcpy(quadruples, out, out_count * sizeof(Quadruple));
+    quad_count = out_count;
+    remapFunctionQuadRanges(new_index);
+
+    free(out); free(source); free(new_index);
+    free(owner); free(call_of); free(param_pos); free(stack); free(callee); free(copy);
+    return converted;
+}
@@ -0,0 +1,55 @@
+// Converts quadruple files between the text format (quadruples.txt) and the
+// binary format (.qir).
+//   quadconv to-bin  quadruples.txt quadruples.qir
+//   quadconv to-text quadruples.qir quadruples.txt
+#include <stdio.h>
+#include <string.h>
+#include "quadruple.h"
+#include "ir_binary.h"
+
+static int text_to_binary(const char *in, const char *out) {
+    FILE *fp = fopen(in, "r");
+    if (!fp) {
+        printf("Error opening file %s\n", in);
+        return 1;
+    }
+    int count = read_quadruples_text(fp);
+    fclose(fp);
+    if (count < 0) {
+        printf("Malformed quadruple in %s\n", in);
+        return 1;
+    }
+    if (write_quadruples_binary(out) != 0) return 1;
+    printf("Converted %d quadruple(s) to %s\n", count, out);
+    return 0;
+}
+
+static int binary_to_text(const char *in, const char *out) {
+    int count = load_quadruples_binary(in);
+    if (count < 0) {
+        printf("Invalid quadruple file %s\n", in);
+        return 1;
+    }
+    FILE *fp = fopen(out, "w");
+    if (!fp) {
+        printf("Error opening file %s\n", out);
+        return 1;
+    }
+    write_quadruples_text(fp);
+    fclose(fp);
+    printf("Converted %d quadruple(s) to %s\n", count, out);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int status = 1;
+    if (argc == 4 && strcmp(argv[1], "to-bin") == 0) {
+        status = text_to_binary(argv[2], argv[3]);
+    } else if (argc == 4 && strcmp(argv[1], "to-text") == 0) {
+        status = binary_to_text(argv[2], argv[3]);
+    } else {
+        printf("Usage: %s to-bin|to-text <input> <output>\n", argv[0]);
+    }
+    free_quadruples();
+    return status;
+}